@@ -1,401 +1,3096 @@
-#include <bits/stdc++.h>
-
-using namespace std;
-
-string trim(const string& str) {
-    size_t first = str.find_first_not_of(" \t");
-    if (first == string::npos) return "";
-    size_t last = str.find_last_not_of(" \t");
-    return str.substr(first, last - first + 1);
-}
-
-string read_file(const string& filename) {
-    ifstream file(filename);
-    if (!file.is_open()) {
-        cerr << "Error opening file: " << filename << endl;
-        return "";
-    }
-    string content((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
-    return content;
-}
-
-vector<vector<string>> parse_csv(const string& csv_content) {
-    vector<vector<string>> data;
-    stringstream ss(csv_content);
-    string line;
-    while (getline(ss, line)) {
-        vector<string> row;
-        stringstream ssline(line);
-        string cell;
-        bool in_quote = false;
-        string temp = "";
-        while (getline(ssline, cell, ',')) {
-            if (in_quote) {
-                temp += "," + cell;
-                if (!cell.empty() && cell.back() == '"') {
-                    temp = temp.substr(1, temp.size() - 2);
-                    row.push_back(trim(temp));
-                    in_quote = false;
-                }
-            }
-            else {
-                if (!cell.empty() && cell.front() == '"') {
-                    if (cell.back() == '"') {
-                        row.push_back(trim(cell.substr(1, cell.size() - 2)));
-                    }
-                    else {
-                        in_quote = true;
-                        temp = cell;
-                    }
-                }
-                else {
-                    row.push_back(trim(cell));
-                }
-            }
-        }
-        data.push_back(row);
-    }
-    return data;
-}
-
-struct TimeSlot {
-    int id;
-    string day;
-    string startTime;
-    string endTime;
-};
-
-struct Room {
-    string id;
-    string building;
-    string space;
-    int capacity;
-    string type;
-};
-
-struct Instructor {
-    int id;
-    string name;
-    string preferredSlots;
-    vector<string> qualifiedCourses;
-};
-
-struct TA {
-    int id;
-    string name;
-    string preferredSlots;
-    map<string, string> qualifiedCourses; // course -> role
-};
-
-struct Section {
-    string faculty;
-    int year;
-    string dept;
-    int groupNumber;
-    int sectionNumber;
-    int studentNumber;
-};
-
-struct Course {
-    int year;
-    int semester;
-    string specialization;
-    string code;
-    string title;
-    int lecSlots;
-    int tutSlots;
-    int labSlots;
-};
-
-struct Session {
-    string type; // "Lecture", "Tutorial", "Lab"
-    string courseCode;
-    int sectionIndex;
-    int instance;
-};
-
-struct Assignment {
-    int timeId = -1;
-    int roomIndex = -1;
-    int teacherIndex = -1; // index in instructors or tas depending on type
-};
-
-vector<TimeSlot> timeSlots;
-vector<Room> rooms;
-vector<Instructor> instructors;
-vector<TA> tas;
-vector<Section> sections;
-vector<Course> courses;
-vector<Session> sessions;
-vector<Assignment> assignments;
-
-void load_timeslots(const string& filename) {
-    string content = read_file(filename);
-    auto data = parse_csv(content);
-    for (size_t i = 1; i < data.size(); ++i) {
-        auto& row = data[i];
-        if (row.size() < 4) continue;
-        string day = row[0];
-        string start = row[1];
-        string end = row[2];
-        int id = stoi(row[3]);
-        timeSlots.push_back({ id, day, start, end });
-    }
-}
-
-void load_rooms(const string& filename) {
-    string content = read_file(filename);
-    auto data = parse_csv(content);
-    string curr_building = "";
-    for (size_t i = 1; i < data.size(); ++i) {
-        auto& row = data[i];
-        if (row.size() < 4) continue;
-        if (!row[0].empty()) curr_building = row[0];
-        string space = row[1];
-        if (space.empty()) continue;
-        int cap = stoi(row[2]);
-        string type = row[3];
-        string id = curr_building + " " + space;
-        rooms.push_back({ trim(id), trim(curr_building), trim(space), cap, trim(type) });
-    }
-}
-
-void load_instructors(const string& filename) {
-    string content = read_file(filename);
-    auto data = parse_csv(content);
-    for (size_t i = 1; i < data.size(); ++i) {
-        auto& row = data[i];
-        if (row.size() < 4) continue;
-        int id = stoi(row[0]);
-        string name = row[1];
-        string pref = row[2];
-        string qual_str = row[3];
-        vector<string> quals;
-        stringstream ss(qual_str);
-        string course;
-        while (getline(ss, course, ',')) {
-            quals.push_back(trim(course));
-        }
-        instructors.push_back({ id, name, pref, quals });
-    }
-}
-
-void load_tas(const string& filename) {
-    string content = read_file(filename);
-    auto data = parse_csv(content);
-    for (size_t i = 1; i < data.size(); ++i) {
-        auto& row = data[i];
-        if (row.size() < 4) continue;
-        int id = stoi(row[0]);
-        string name = row[1];
-        string pref = row[2];
-        string qual_str = row[3];
-        TA ta = { id, name, pref, {} };
-        stringstream ss(qual_str);
-        string token;
-        while (getline(ss, token, ',')) {
-            token = trim(token);
-            size_t par_pos = token.find('(');
-            if (par_pos != string::npos) {
-                string course = trim(token.substr(0, par_pos));
-                size_t end_par = token.rfind(')');
-                string role = trim(token.substr(par_pos + 1, end_par - par_pos - 1));
-                ta.qualifiedCourses[course] = role;
-            }
-        }
-        tas.push_back(ta);
-    }
-}
-
-void load_sections(const string& filename) {
-    string content = read_file(filename);
-    auto data = parse_csv(content);
-    string curr_faculty = "", curr_dept = "";
-    int curr_year = 0, curr_group = 0;
-    for (size_t i = 1; i < data.size(); ++i) {
-        auto& row = data[i];
-        if (row.size() < 6) continue;
-        if (!row[0].empty()) curr_faculty = row[0];
-        if (!row[1].empty()) curr_year = stoi(row[1]);
-        if (!row[2].empty()) curr_dept = row[2];
-        if (!row[3].empty()) curr_group = stoi(row[3]);
-        if (!row[4].empty() && !row[5].empty()) {
-            int sec_num = stoi(row[4]);
-            int stu_num = stoi(row[5]);
-            sections.push_back({ curr_faculty, curr_year, curr_dept, curr_group, sec_num, stu_num });
-        }
-    }
-}
-
-void load_courses(const string& filename) {
-    string content = read_file(filename);
-    auto data = parse_csv(content);
-    int curr_year_c = 0, curr_sem = 0;
-    string curr_spec = "";
-    for (size_t i = 1; i < data.size(); ++i) {
-        auto& row = data[i];
-        if (row.size() < 8) continue;
-        if (!row[0].empty()) curr_year_c = stoi(row[0]);
-        if (!row[1].empty()) curr_sem = stoi(row[1]);
-        if (!row[2].empty()) curr_spec = row[2];
-        string code = row[3];
-        if (code.empty()) continue;
-        string title = row[4];
-        int lec = stoi(row[5]);
-        int tut = stoi(row[6]);
-        int lab = stoi(row[7]);
-        courses.push_back({ curr_year_c, curr_sem, curr_spec, code, title, lec, tut, lab });
-    }
-}
-
-bool match_room(const Session& s, const Room& room, const Section& sec) {
-    if (room.capacity < sec.studentNumber) return false;
-    string room_type = room.type;
-    if (s.type == "Lecture" || s.type == "Tutorial") {
-        if (room_type == "Classroom" || room_type == "Hall" || room_type == "Theater") return true;
-    }
-    else { // Lab
-        if (s.courseCode.find("PHY") != string::npos) {
-            if (room_type == "PHY_LAB") return true;
-        }
-        else if (s.courseCode.find("Drawing") != string::npos) {
-            if (room_type == "Drawing Studio" || room_type == "FoE Drawing Lab") return true;
-        }
-        else if (room_type == "Computer Lab" || room_type == "Lab") return true;
-    }
-    return false;
-}
-
-bool check_constraints(int pos) {
-    const Session& curr_session = sessions[pos];
-    const Assignment& curr_assign = assignments[pos];
-    int curr_time = curr_assign.timeId;
-    int curr_room = curr_assign.roomIndex;
-    int curr_teacher = curr_assign.teacherIndex;
-    string curr_type = curr_session.type;
-    int curr_sec = curr_session.sectionIndex;
-
-    // Room conflict
-    for (int i = 0; i < pos; ++i) {
-        if (assignments[i].timeId == curr_time && assignments[i].roomIndex == curr_room) return false;
-    }
-
-    // Student group (section) conflict
-    for (int i = 0; i < pos; ++i) {
-        if (sessions[i].sectionIndex == curr_sec && assignments[i].timeId == curr_time) return false;
-    }
-
-    // Teacher conflict
-    for (int i = 0; i < pos; ++i) {
-        if (assignments[i].timeId == curr_time && assignments[i].teacherIndex == curr_teacher) {
-            if (curr_type == "Lecture" && sessions[i].type == "Lecture") return false;
-            if (curr_type != "Lecture" && sessions[i].type != "Lecture") return false;
-        }
-    }
-
-    return true;
-}
-
-bool solve(int pos) {
-    if (pos == sessions.size()) return true;
-
-    const Session& s = sessions[pos];
-    const Section& sec = sections[s.sectionIndex];
-
-    vector<int> possible_times;
-    for (int t = 0; t < timeSlots.size(); ++t) possible_times.push_back(t);
-
-    vector<int> possible_rooms;
-    for (int r = 0; r < rooms.size(); ++r) {
-        if (match_room(s, rooms[r], sec)) possible_rooms.push_back(r);
-    }
-
-    vector<int> possible_teachers;
-    if (s.type == "Lecture") {
-        for (int i = 0; i < instructors.size(); ++i) {
-            auto& quals = instructors[i].qualifiedCourses;
-            if (find(quals.begin(), quals.end(), s.courseCode) != quals.end()) {
-                possible_teachers.push_back(i);
-            }
-        }
-    }
-    else {
-        for (int ta_idx = 0; ta_idx < tas.size(); ++ta_idx) {
-            auto& qual_map = tas[ta_idx].qualifiedCourses;
-            auto it = qual_map.find(s.courseCode);
-            if (it != qual_map.end() &&
-                ((s.type == "Tutorial" && it->second.find("TUT") != string::npos) ||
-                    (s.type == "Lab" && it->second.find("LAB") != string::npos))) {
-                possible_teachers.push_back(ta_idx);
-            }
-        }
-    }
-
-    for (int t : possible_times) {
-        for (int r : possible_rooms) {
-            for (int teach : possible_teachers) {
-                assignments[pos] = { t, r, teach };
-                if (check_constraints(pos)) {
-                    if (solve(pos + 1)) return true;
-                }
-            }
-        }
-    }
-    assignments[pos] = { -1, -1, -1 };
-    return false;
-}
-
-void print_timetable() {
-    for (int i = 0; i < sessions.size(); ++i) {
-        const Session& s = sessions[i];
-        const Assignment& a = assignments[i];
-        const Section& sec = sections[s.sectionIndex];
-        const TimeSlot& ts = timeSlots[a.timeId];
-        const Room& rm = rooms[a.roomIndex];
-        string teacher_name = (s.type == "Lecture") ? instructors[a.teacherIndex].name : tas[a.teacherIndex].name;
-
-        cout << "Year: " << sec.year << ", Dept: " << sec.dept << ", Group: " << sec.groupNumber << ", Section: " << sec.sectionNumber << endl;
-        cout << "Type: " << s.type << ", Course: " << s.courseCode << ", Instance: " << s.instance << endl;
-        cout << "Time: " << ts.day << " " << ts.startTime << " - " << ts.endTime << endl;
-        cout << "Room: " << rm.id << endl;
-        cout << "Teacher: " << teacher_name << endl;
-        cout << "------------------------" << endl;
-    }
-}
-
-int main() {
-    load_timeslots("TimeSlots.csv");
-    load_rooms("Halls.csv");
-    load_instructors("Instructor.csv");
-    load_tas("TAs.csv");
-    load_sections("Sections.csv");
-    load_courses("Courses.csv");
-
-    // Generate sessions for each section's courses
-    for (const auto& c : courses) {
-        if (c.lecSlots + c.tutSlots + c.labSlots == 0) continue;
-        vector<int> relevant_sections;
-        for (int si = 0; si < sections.size(); ++si) {
-            const auto& sec = sections[si];
-            if (sec.year == c.year && (c.specialization == "N/A" || sec.dept.empty() || sec.dept == c.specialization)) {
-                relevant_sections.push_back(si);
-            }
-        }
-        for (int si : relevant_sections) {
-            for (int inst = 0; inst < c.lecSlots; ++inst) sessions.push_back({ "Lecture", c.code, si, inst });
-            for (int inst = 0; inst < c.tutSlots; ++inst) sessions.push_back({ "Tutorial", c.code, si, inst });
-            for (int inst = 0; inst < c.labSlots; ++inst) sessions.push_back({ "Lab", c.code, si, inst });
-        }
-    }
-
-    assignments.resize(sessions.size(), { -1, -1, -1 });
-
-    if (solve(0)) {
-        print_timetable();
-    }
-    else {
-        cout << "No feasible timetable found without conflicts." << endl;
-    }
-
-    return 0;
+#include <bits/stdc++.h>
+#include "csv_reader.h"
+#include "xlsx_reader.h"
+#include "snapshot_io.h"
+#include "search_stats.h"
+#include "search_arena.h"
+#include "timetable_export.h"
+#include "sat_engine.h"
+#include "room_rules.h"
+#include "soft_weights.h"
+
+using namespace std;
+
+string trim(const string& str) {
+    size_t first = str.find_first_not_of(" \t");
+    if (first == string::npos) return "";
+    size_t last = str.find_last_not_of(" \t");
+    return str.substr(first, last - first + 1);
+}
+
+// Opens name.csv, or the registrar's name.xlsx when the CSV is missing or
+// workbooks are forced; unreadable input loads as an empty table.
+unique_ptr<CsvTable> read_table(const string& name, bool xlsx) {
+    if (!xlsx) {
+        auto csv = make_unique<CsvFile>();
+        if (csv->open(name + ".csv")) return csv;
+    }
+    auto book = make_unique<XlsxFile>();
+    if (book->open(name + ".xlsx")) return book;
+    cerr << "Error opening file: " << name << (xlsx ? ".xlsx" : ".csv") << endl;
+    return make_unique<CsvTable>();
+}
+
+int to_int(string_view cell) {
+    int value = 0;
+    auto [end, ec] = from_chars(cell.data(), cell.data() + cell.size(), value);
+    if (ec != errc() || end != cell.data() + cell.size()) throw invalid_argument("not an integer: " + string(cell));
+    return value;
+}
+
+// Maps string keys (course codes, room ids, ...) to dense integer ids at load time.
+struct Interner {
+    unordered_map<string, int> ids;
+    vector<string> names;
+
+    int intern(const string& key) {
+        auto it = ids.find(key);
+        if (it != ids.end()) return it->second;
+        int id = names.size();
+        ids.emplace(key, id);
+        names.push_back(key);
+        return id;
+    }
+    int find(const string& key) const {
+        auto it = ids.find(key);
+        return it == ids.end() ? -1 : it->second;
+    }
+};
+
+enum SessionType : uint8_t { LECTURE, TUTORIAL, LAB };
+
+const char* session_type_name(SessionType t) {
+    switch (t) {
+    case LECTURE: return "Lecture";
+    case TUTORIAL: return "Tutorial";
+    default: return "Lab";
+    }
+}
+
+// TA role bits
+enum : uint8_t { ROLE_TUT = 1, ROLE_LAB = 2 };
+
+struct TimeSlot {
+    int id;
+    string day;
+    string startTime;
+    string endTime;
+};
+
+struct Room {
+    string id;
+    string building;
+    string space;
+    int capacity;
+    string type;
+};
+
+struct Instructor {
+    int id;
+    string name;
+    string preferredSlots;
+    vector<int> qualifiedCourses; // interned course codes
+};
+
+struct TA {
+    int id;
+    string name;
+    string preferredSlots;
+    unordered_map<int, uint8_t> qualifiedCourses; // course id -> ROLE_* bits
+};
+
+struct Section {
+    string faculty;
+    int year;
+    string dept;
+    int groupNumber;
+    int sectionNumber;
+    int studentNumber;
+};
+
+struct Course {
+    int year;
+    int semester;
+    string specialization;
+    string code;
+    int codeId;
+    string title;
+    int lecSlots;
+    int tutSlots;
+    int labSlots;
+};
+
+// A run of ints inside a vector, for range-for.
+struct IndexRange {
+    const int* first;
+    const int* last;
+    const int* begin() const { return first; }
+    const int* end() const { return last; }
+};
+
+// Sessions to schedule, one row per session (struct of arrays). A session is
+// attended by one section, or by every section of a group for a shared lecture.
+struct SessionTable {
+    vector<SessionType> type;
+    vector<int> course;       // interned course code
+    vector<int> sectionIndex; // first section attending
+    vector<int> instance;
+    vector<int> sectionStart{ 0 };  // session -> offset into sectionList (size sessions + 1)
+    vector<int> sectionList;
+
+    int size() const { return type.size(); }
+    void add(SessionType t, int c, const vector<int>& secs, int inst) {
+        type.push_back(t);
+        course.push_back(c);
+        sectionIndex.push_back(secs[0]);
+        instance.push_back(inst);
+        sectionList.insert(sectionList.end(), secs.begin(), secs.end());
+        sectionStart.push_back(sectionList.size());
+    }
+    void add(SessionType t, int c, int sec, int inst) { add(t, c, vector<int>{ sec }, inst); }
+    IndexRange sections_of(int pos) const { return { sectionList.data() + sectionStart[pos], sectionList.data() + sectionStart[pos + 1] }; }
+};
+
+// Assignment of every session (struct of arrays), -1 when unassigned.
+struct AssignmentTable {
+    vector<int> timeId;
+    vector<int> roomIndex;
+    vector<int> teacherIndex; // index in instructors or tas depending on type
+
+    void reset(int n) {
+        timeId.assign(n, -1);
+        roomIndex.assign(n, -1);
+        teacherIndex.assign(n, -1);
+    }
+    void set(int pos, int t, int r, int teach) {
+        timeId[pos] = t;
+        roomIndex[pos] = r;
+        teacherIndex[pos] = teach;
+    }
+};
+
+vector<TimeSlot> timeSlots;
+vector<Room> rooms;
+vector<Instructor> instructors;
+vector<TA> tas;
+vector<Section> sections;
+vector<Course> courses;
+SessionTable sessions;
+
+// Search state is thread_local: every parallel worker owns its own assignment,
+// occupancy tables, trail and nogoods, while the loaded entities and compiled
+// domains above are shared read-only.
+thread_local AssignmentTable assignments;
+thread_local SearchStats stats;  // see search_stats.h
+thread_local int workerId = 0;   // this thread's slot in workerStats and the progress reporter
+ProgressReporter progress;
+
+Interner courseCodes;
+Interner roomIds;
+
+// Dense 2D bit matrix: one row of 64-bit words per timeslot.
+struct BitTable {
+    int words = 0;
+    vector<uint64_t> bits;
+
+    void init(int rows, int cols) {
+        words = (cols + 63) / 64;
+        bits.assign((size_t)rows * words, 0);
+    }
+    bool test(int row, int col) const {
+        return (bits[(size_t)row * words + (col >> 6)] >> (col & 63)) & 1;
+    }
+    void set(int row, int col) {
+        bits[(size_t)row * words + (col >> 6)] |= uint64_t(1) << (col & 63);
+    }
+    void reset(int row, int col) {
+        bits[(size_t)row * words + (col >> 6)] &= ~(uint64_t(1) << (col & 63));
+    }
+    const uint64_t* row(int r) const { return bits.data() + (size_t)r * words; }
+    uint64_t* row(int r) { return bits.data() + (size_t)r * words; }
+};
+
+// True if some bit set in mask is clear in busy.
+bool any_free(const uint64_t* mask, const uint64_t* busy, int words) {
+    for (int w = 0; w < words; ++w) {
+        if (mask[w] & ~busy[w]) return true;
+    }
+    return false;
+}
+
+int count_free(const uint64_t* mask, const uint64_t* busy, int words) {
+    int n = 0;
+    for (int w = 0; w < words; ++w) n += __builtin_popcountll(mask[w] & ~busy[w]);
+    return n;
+}
+
+// First bit above after that is set in mask and clear in busy, or -1.
+int next_free(const uint64_t* mask, const uint64_t* busy, int words, int after) {
+    int w = (after + 1) >> 6;
+    if (w >= words) return -1;
+    uint64_t bits = mask[w] & ~busy[w] & (~uint64_t(0) << ((after + 1) & 63));
+    while (!bits) {
+        if (++w == words) return -1;
+        bits = mask[w] & ~busy[w];
+    }
+    return w * 64 + __builtin_ctzll(bits);
+}
+
+// Per-timeslot occupancy of every resource, updated as solve() assigns and unassigns.
+// Instructors and TAs live in separate tables, so a Lecture and a non-Lecture with
+// the same teacher index never conflict.
+// The owner tables record which session holds each busy (time, resource) pair;
+// they are read to explain failures and, with matchRooms, to rematch rooms.
+struct Occupancy {
+    BitTable rooms;
+    BitTable sections;
+    BitTable instructors;
+    BitTable tas;
+    vector<int> roomOwner;        // t * rooms + r -> session
+    vector<int> sectionOwner;     // t * sections + s -> session
+    vector<int> instructorOwner;  // t * instructors + i -> session
+    vector<int> taOwner;          // t * tas + i -> session
+};
+
+thread_local Occupancy occupancy;
+
+// True if some section attending pos is busy at t.
+bool sections_busy(int pos, int t) {
+    for (int sec : sessions.sections_of(pos)) {
+        if (occupancy.sections.test(t, sec)) return true;
+    }
+    return false;
+}
+
+// Candidate rooms and teachers, compiled once per distinct (course, session type,
+// section size) key. Sessions with the same requirements share one domain class;
+// every time slot is a candidate for every session.
+struct DomainTable {
+    vector<int> sessionClass;  // session -> domain class
+    vector<int> roomStart;     // class -> offset into roomPool (size classes + 1)
+    vector<int> teacherStart;  // class -> offset into teacherPool (size classes + 1)
+    vector<int> roomPool;
+    vector<int> teacherPool;
+
+    int classes() const { return (int)roomStart.size() - 1; }
+};
+
+DomainTable domains;
+
+void load_timeslots(const CsvTable& data) {
+    for (size_t i = 1; i < data.rows(); ++i) {
+        CsvRow row = data[i];
+        if (row.size() < 4) continue;
+        string day(row[0]);
+        string start(row[1]);
+        string end(row[2]);
+        int id = to_int(row[3]);
+        timeSlots.push_back({ id, day, start, end });
+    }
+}
+
+void load_rooms(const CsvTable& data) {
+    string curr_building = "";
+    for (size_t i = 1; i < data.rows(); ++i) {
+        CsvRow row = data[i];
+        if (row.size() < 4) continue;
+        if (!row[0].empty()) curr_building = row[0];
+        string space(row[1]);
+        if (space.empty()) continue;
+        int cap = to_int(row[2]);
+        string type(row[3]);
+        string id = trim(curr_building + " " + space);
+        if (roomIds.find(id) >= 0) {
+            cerr << "Halls row " << i + 1 << ": " << id << " repeats an earlier room and is skipped" << endl;
+            continue;
+        }
+        roomIds.intern(id);
+        rooms.push_back({ id, trim(curr_building), trim(space), cap, trim(type) });
+    }
+}
+
+void load_instructors(const CsvTable& data) {
+    for (size_t i = 1; i < data.rows(); ++i) {
+        CsvRow row = data[i];
+        if (row.size() < 4) continue;
+        int id = to_int(row[0]);
+        string name(row[1]);
+        string pref(row[2]);
+        string qual_str(row[3]);
+        vector<int> quals;
+        stringstream ss(qual_str);
+        string course;
+        while (getline(ss, course, ',')) {
+            quals.push_back(courseCodes.intern(trim(course)));
+        }
+        instructors.push_back({ id, name, pref, quals });
+    }
+}
+
+// Qualifications in the TAs table's form: "PHY 113 (TUT + LAB), CNC 111 (LAB)".
+void parse_ta_qualifications(const string& qual_str, TA& ta) {
+    stringstream ss(qual_str);
+    string token;
+    while (getline(ss, token, ',')) {
+        token = trim(token);
+        size_t par_pos = token.find('(');
+        if (par_pos != string::npos) {
+            string course = trim(token.substr(0, par_pos));
+            size_t end_par = token.rfind(')');
+            string role = trim(token.substr(par_pos + 1, end_par - par_pos - 1));
+            uint8_t roles = 0;
+            if (role.find("TUT") != string::npos) roles |= ROLE_TUT;
+            if (role.find("LAB") != string::npos) roles |= ROLE_LAB;
+            ta.qualifiedCourses[courseCodes.intern(course)] = roles;
+        }
+    }
+}
+
+void load_tas(const CsvTable& data) {
+    for (size_t i = 1; i < data.rows(); ++i) {
+        CsvRow row = data[i];
+        if (row.size() < 4) continue;
+        int id = to_int(row[0]);
+        string name(row[1]);
+        string pref(row[2]);
+        TA ta = { id, name, pref, {} };
+        parse_ta_qualifications(string(row[3]), ta);
+        tas.push_back(ta);
+    }
+}
+
+void load_sections(const CsvTable& data) {
+    string curr_faculty = "", curr_dept = "";
+    int curr_year = 0, curr_group = 0;
+    for (size_t i = 1; i < data.rows(); ++i) {
+        CsvRow row = data[i];
+        if (row.size() < 6) continue;
+        if (!row[0].empty()) curr_faculty = row[0];
+        if (!row[1].empty()) curr_year = to_int(row[1]);
+        if (!row[2].empty()) curr_dept = row[2];
+        if (!row[3].empty()) curr_group = to_int(row[3]);
+        if (!row[4].empty() && !row[5].empty()) {
+            int sec_num = to_int(row[4]);
+            int stu_num = to_int(row[5]);
+            sections.push_back({ curr_faculty, curr_year, curr_dept, curr_group, sec_num, stu_num });
+        }
+    }
+}
+
+void load_courses(const CsvTable& data) {
+    int curr_year_c = 0, curr_sem = 0;
+    string curr_spec = "";
+    for (size_t i = 1; i < data.rows(); ++i) {
+        CsvRow row = data[i];
+        if (row.size() < 8) continue;
+        if (!row[0].empty()) curr_year_c = to_int(row[0]);
+        if (!row[1].empty()) curr_sem = to_int(row[1]);
+        if (!row[2].empty()) curr_spec = row[2];
+        string code(row[3]);
+        if (code.empty()) continue;
+        string title(row[4]);
+        int lec = to_int(row[5]);
+        int tut = to_int(row[6]);
+        int lab = to_int(row[7]);
+        courses.push_back({ curr_year_c, curr_sem, curr_spec, code, courseCodes.intern(code), title, lec, tut, lab });
+    }
+}
+
+// Room-compatibility rules (see room_rules.h): timetable_room_rules() unless
+// a RoomRules table beside the others replaces them.
+RoomRules roomRules;
+
+// Loads the rules and compiles them for the loaded rooms and courses; false,
+// with a message, when the table is malformed.
+bool load_room_rules(bool xlsx) {
+    roomRules.rules = timetable_room_rules();
+    unique_ptr<CsvTable> table;
+    auto csv = make_unique<CsvFile>();
+    auto book = make_unique<XlsxFile>();
+    if (!xlsx && csv->open("RoomRules.csv")) table = move(csv);
+    else if (book->open("RoomRules.xlsx")) table = move(book);
+    string error;
+    if (table && !roomRules.load(*table, error)) {
+        cerr << "RoomRules " << error << endl;
+        return false;
+    }
+    vector<string> types;
+    for (const auto& room : rooms) types.push_back(room.type);
+    if (!roomRules.compile(courseCodes.names, types)) {
+        cerr << "RoomRules: more than 64 distinct room classes" << endl;
+        return false;
+    }
+    return true;
+}
+
+bool match_room(SessionType type, int course, int room, int students) {
+    return roomRules.fits(course, type, room, rooms[room].capacity, students);
+}
+
+bool qualified_teacher(SessionType type, int course, int teacher) {
+    if (type == LECTURE) {
+        auto& quals = instructors[teacher].qualifiedCourses;
+        return find(quals.begin(), quals.end(), course) != quals.end();
+    }
+    auto& qual_map = tas[teacher].qualifiedCourses;
+    auto it = qual_map.find(course);
+    return it != qual_map.end() &&
+        ((type == TUTORIAL && (it->second & ROLE_TUT)) ||
+            (type == LAB && (it->second & ROLE_LAB)));
+}
+
+void compile_domains() {
+    domains = DomainTable();
+    domains.roomStart.push_back(0);
+    domains.teacherStart.push_back(0);
+    map<tuple<int, int, int>, int> class_of; // (course, type, students) -> class
+    for (int pos = 0; pos < sessions.size(); ++pos) {
+        SessionType type = sessions.type[pos];
+        int course = sessions.course[pos];
+        int students = 0;
+        for (int sec : sessions.sections_of(pos)) students += sections[sec].studentNumber;
+        auto key = make_tuple(course, (int)type, students);
+        auto it = class_of.find(key);
+        if (it != class_of.end()) {
+            domains.sessionClass.push_back(it->second);
+            continue;
+        }
+        int cls = domains.classes();
+        class_of.emplace(key, cls);
+        domains.sessionClass.push_back(cls);
+
+        for (int r = 0; r < (int)rooms.size(); ++r) {
+            if (match_room(type, course, r, students)) domains.roomPool.push_back(r);
+        }
+        int num_teachers = (type == LECTURE) ? instructors.size() : tas.size();
+        for (int teach = 0; teach < num_teachers; ++teach) {
+            if (qualified_teacher(type, course, teach)) domains.teacherPool.push_back(teach);
+        }
+        domains.roomStart.push_back(domains.roomPool.size());
+        domains.teacherStart.push_back(domains.teacherPool.size());
+    }
+}
+
+// With sharedLectures a group's sections attend each lecture of a course
+// together: one session seating all of them, while tutorials and labs stay
+// per section. --section-lectures turns this off for the whole run. Which
+// lectures are shared depends only on the Sections and Courses tables, never
+// on the rooms, so closing rooms in a scenario or a repair keeps the sessions.
+bool sharedLectures = true;
+
+// Sessions for each section's courses.
+void generate_sessions() {
+    int unseated = 0;
+    for (const auto& c : courses) {
+        if (c.lecSlots + c.tutSlots + c.labSlots == 0) continue;
+        // relevant sections by group, in table order
+        map<tuple<string, int, string, int>, int> group_of;
+        vector<vector<int>> groups;
+        for (int si = 0; si < (int)sections.size(); ++si) {
+            const auto& sec = sections[si];
+            if (sec.year == c.year && (c.specialization == "N/A" || sec.dept.empty() || sec.dept == c.specialization)) {
+                auto key = make_tuple(sec.faculty, sec.year, sec.dept, sharedLectures ? sec.groupNumber : si);
+                auto it = group_of.emplace(key, groups.size()).first;
+                if (it->second == (int)groups.size()) groups.emplace_back();
+                groups[it->second].push_back(si);
+            }
+        }
+        for (const auto& group : groups) {
+            if (group.size() > 1 && c.lecSlots > 0) {
+                int students = 0;
+                for (int si : group) students += sections[si].studentNumber;
+                bool seated = false;
+                for (int r = 0; r < (int)rooms.size() && !seated; ++r) seated = match_room(LECTURE, c.codeId, r, students);
+                unseated += !seated;
+            }
+            for (int inst = 0; inst < c.lecSlots; ++inst) sessions.add(LECTURE, c.codeId, group, inst);
+            for (int si : group) {
+                for (int inst = 0; inst < c.tutSlots; ++inst) sessions.add(TUTORIAL, c.codeId, si, inst);
+                for (int inst = 0; inst < c.labSlots; ++inst) sessions.add(LAB, c.codeId, si, inst);
+            }
+        }
+    }
+    if (unseated) cerr << unseated << " group lectures have no room seating the whole group; --section-lectures holds them per section" << endl;
+}
+
+// Compiled-problem snapshot: the loaded entities, interned names, sessions and
+// domain table, written column by column through snapshot_io.h. A run with
+// --snapshot FILE reuses the snapshot while the source tables hash the same
+// and rebuilds it otherwise. Bump SNAPSHOT_VERSION whenever the layout below
+// or anything it is derived from changes.
+const char SNAPSHOT_TAG[4] = { 'C', 'A', '1', 0 };
+const uint32_t SNAPSHOT_VERSION = 4;
+const char* SOURCE_TABLES[] = { "TimeSlots", "Halls", "Instructor", "TAs", "Sections", "Courses", "RoomRules" };
+
+uint64_t source_hash(bool xlsx) {
+    vector<string> paths;
+    for (const char* name : SOURCE_TABLES) {
+        paths.push_back(string(name) + ".csv");
+        paths.push_back(string(name) + ".xlsx");
+    }
+    // the sessions differ with and without shared lectures
+    return hash_files(paths) ^ xlsx ^ (uint64_t)sharedLectures << 1;
+}
+
+template <class T, class F> vector<F> column(const vector<T>& rows, F T::*field) {
+    vector<F> out;
+    out.reserve(rows.size());
+    for (const auto& row : rows) out.push_back(row.*field);
+    return out;
+}
+
+template <class T, class F> void fill_column(vector<T>& rows, F T::*field, vector<F>&& values) {
+    rows.resize(values.size());
+    for (size_t i = 0; i < values.size(); ++i) rows[i].*field = move(values[i]);
+}
+
+void restore_ids(Interner& interner) {
+    interner.ids.clear();
+    for (int i = 0; i < (int)interner.names.size(); ++i) interner.ids.emplace(interner.names[i], i);
+}
+
+bool save_snapshot(const string& path, uint64_t hash) {
+    SnapshotWriter out;
+    out.array(column(timeSlots, &TimeSlot::id));
+    out.strings(column(timeSlots, &TimeSlot::day));
+    out.strings(column(timeSlots, &TimeSlot::startTime));
+    out.strings(column(timeSlots, &TimeSlot::endTime));
+
+    out.strings(column(rooms, &Room::id));
+    out.strings(column(rooms, &Room::building));
+    out.strings(column(rooms, &Room::space));
+    out.array(column(rooms, &Room::capacity));
+    out.strings(column(rooms, &Room::type));
+
+    vector<int> qual_start{ 0 }, qual_course;
+    for (const auto& ins : instructors) {
+        qual_course.insert(qual_course.end(), ins.qualifiedCourses.begin(), ins.qualifiedCourses.end());
+        qual_start.push_back(qual_course.size());
+    }
+    out.array(column(instructors, &Instructor::id));
+    out.strings(column(instructors, &Instructor::name));
+    out.strings(column(instructors, &Instructor::preferredSlots));
+    out.array(qual_start);
+    out.array(qual_course);
+
+    vector<int> ta_start{ 0 }, ta_course;
+    vector<uint8_t> ta_roles;
+    for (const auto& ta : tas) {
+        for (auto [course, roles] : ta.qualifiedCourses) {
+            ta_course.push_back(course);
+            ta_roles.push_back(roles);
+        }
+        ta_start.push_back(ta_course.size());
+    }
+    out.array(column(tas, &TA::id));
+    out.strings(column(tas, &TA::name));
+    out.strings(column(tas, &TA::preferredSlots));
+    out.array(ta_start);
+    out.array(ta_course);
+    out.array(ta_roles);
+
+    out.strings(column(sections, &Section::faculty));
+    out.array(column(sections, &Section::year));
+    out.strings(column(sections, &Section::dept));
+    out.array(column(sections, &Section::groupNumber));
+    out.array(column(sections, &Section::sectionNumber));
+    out.array(column(sections, &Section::studentNumber));
+
+    out.array(column(courses, &Course::year));
+    out.array(column(courses, &Course::semester));
+    out.strings(column(courses, &Course::specialization));
+    out.strings(column(courses, &Course::code));
+    out.array(column(courses, &Course::codeId));
+    out.strings(column(courses, &Course::title));
+    out.array(column(courses, &Course::lecSlots));
+    out.array(column(courses, &Course::tutSlots));
+    out.array(column(courses, &Course::labSlots));
+
+    out.strings(courseCodes.names);
+    out.strings(roomIds.names);
+
+    out.array(sessions.type);
+    out.array(sessions.course);
+    out.array(sessions.sectionIndex);
+    out.array(sessions.instance);
+    out.array(sessions.sectionStart);
+    out.array(sessions.sectionList);
+
+    out.array(domains.sessionClass);
+    out.array(domains.roomStart);
+    out.array(domains.teacherStart);
+    out.array(domains.roomPool);
+    out.array(domains.teacherPool);
+    return out.save(path, SNAPSHOT_TAG, SNAPSHOT_VERSION, hash);
+}
+
+bool read_snapshot(SnapshotReader& in) {
+    vector<int> ints;
+    vector<string> strs;
+    auto int_column = [&]() { in.array(ints); return move(ints); };
+    auto string_column = [&]() { in.strings(strs); return move(strs); };
+
+    fill_column(timeSlots, &TimeSlot::id, int_column());
+    fill_column(timeSlots, &TimeSlot::day, string_column());
+    fill_column(timeSlots, &TimeSlot::startTime, string_column());
+    fill_column(timeSlots, &TimeSlot::endTime, string_column());
+
+    fill_column(rooms, &Room::id, string_column());
+    fill_column(rooms, &Room::building, string_column());
+    fill_column(rooms, &Room::space, string_column());
+    fill_column(rooms, &Room::capacity, int_column());
+    fill_column(rooms, &Room::type, string_column());
+
+    fill_column(instructors, &Instructor::id, int_column());
+    fill_column(instructors, &Instructor::name, string_column());
+    fill_column(instructors, &Instructor::preferredSlots, string_column());
+    vector<int> start = int_column(), course = int_column();
+    for (size_t i = 0; i < instructors.size() && i + 1 < start.size(); ++i) {
+        if (start[i + 1] > (int)course.size()) return false;
+        instructors[i].qualifiedCourses.assign(course.begin() + start[i], course.begin() + start[i + 1]);
+    }
+
+    fill_column(tas, &TA::id, int_column());
+    fill_column(tas, &TA::name, string_column());
+    fill_column(tas, &TA::preferredSlots, string_column());
+    start = int_column();
+    course = int_column();
+    vector<uint8_t> roles;
+    in.array(roles);
+    for (size_t i = 0; i < tas.size() && i + 1 < start.size(); ++i) {
+        if (start[i + 1] > (int)min(course.size(), roles.size())) return false;
+        for (int k = start[i]; k < start[i + 1]; ++k) tas[i].qualifiedCourses[course[k]] = roles[k];
+    }
+
+    fill_column(sections, &Section::faculty, string_column());
+    fill_column(sections, &Section::year, int_column());
+    fill_column(sections, &Section::dept, string_column());
+    fill_column(sections, &Section::groupNumber, int_column());
+    fill_column(sections, &Section::sectionNumber, int_column());
+    fill_column(sections, &Section::studentNumber, int_column());
+
+    fill_column(courses, &Course::year, int_column());
+    fill_column(courses, &Course::semester, int_column());
+    fill_column(courses, &Course::specialization, string_column());
+    fill_column(courses, &Course::code, string_column());
+    fill_column(courses, &Course::codeId, int_column());
+    fill_column(courses, &Course::title, string_column());
+    fill_column(courses, &Course::lecSlots, int_column());
+    fill_column(courses, &Course::tutSlots, int_column());
+    fill_column(courses, &Course::labSlots, int_column());
+
+    in.strings(courseCodes.names);
+    in.strings(roomIds.names);
+    restore_ids(courseCodes);
+    restore_ids(roomIds);
+
+    in.array(sessions.type);
+    in.array(sessions.course);
+    in.array(sessions.sectionIndex);
+    in.array(sessions.instance);
+    in.array(sessions.sectionStart);
+    in.array(sessions.sectionList);
+
+    in.array(domains.sessionClass);
+    in.array(domains.roomStart);
+    in.array(domains.teacherStart);
+    in.array(domains.roomPool);
+    in.array(domains.teacherPool);
+    return in.good() && (int)domains.sessionClass.size() == sessions.size() &&
+        domains.teacherStart.size() == domains.roomStart.size() && (int)sessions.sectionStart.size() == sessions.size() + 1 &&
+        sessions.sectionStart.back() == (int)sessions.sectionList.size();
+}
+
+// Loads a snapshot written by save_snapshot for the same sources; false (and
+// nothing loaded) when it is missing, stale or damaged.
+bool load_snapshot(const string& path, uint64_t hash) {
+    SnapshotReader in;
+    if (!in.open(path, SNAPSHOT_TAG, SNAPSHOT_VERSION, hash)) return false;
+    if (read_snapshot(in)) return true;
+    timeSlots.clear();
+    rooms.clear();
+    instructors.clear();
+    tas.clear();
+    sections.clear();
+    courses.clear();
+    courseCodes = Interner();
+    roomIds = Interner();
+    sessions = SessionTable();
+    domains = DomainTable();
+    return false;
+}
+
+// Forward checking over the time domain of every unassigned session.
+// A time stays in a session's domain while its section is free then and some
+// candidate room and candidate teacher are free then. Resource pools (sessions
+// sharing a section, an identical room set or an identical teacher set) add an
+// alldifferent-style counting check: the free (time, resource) pairs reachable
+// from the pool's open domains must cover its unassigned sessions.
+// Every removal is recorded on a trail and undone on backtrack.
+enum PoolKind : uint8_t { POOL_SECTION, POOL_ROOM, POOL_INSTRUCTOR, POOL_TA };
+
+struct ResourcePool {
+    PoolKind kind;
+    int maskRow;          // row of the pool's resource set in Propagation::poolMasks
+    vector<int> members;  // sessions competing for the pool
+};
+
+// Why a time was removed from a session's domain. PRUNE_TASK removals are the
+// premises of a parallel search task and need no explanation.
+enum PruneReason : uint8_t { PRUNE_SECTION, PRUNE_ROOMS, PRUNE_TEACHERS, PRUNE_TASK };
+
+struct TrailEntry {
+    int session;
+    int time;
+    PruneReason reason;
+    int prev;  // previous trail entry of the same session, -1 if none
+};
+
+struct Propagation {
+    BitTable timeDomain;     // session x time
+    vector<int> domainSize;  // live times per session
+    BitTable classRooms;     // domain class x room
+    BitTable classTeachers;  // domain class x teacher (instructors or TAs, by class)
+    vector<uint8_t> classIsLecture;
+    vector<vector<int>> classSessions;
+    vector<vector<int>> roomClasses;        // room -> classes using it
+    vector<vector<int>> instructorClasses;  // instructor -> lecture classes
+    vector<vector<int>> taClasses;          // TA -> non-lecture classes
+    vector<vector<int>> sectionSessions;
+    BitTable poolMasks;
+    vector<ResourcePool> pools;
+    vector<vector<int>> sessionPools;    // session -> its room and teacher pools, then one per section
+    vector<int> poolStamp;
+    int stamp = 0;
+    vector<TrailEntry> trail;
+    vector<int> lastEntry;         // session -> its newest trail entry, -1 if none
+    vector<int> touched;           // sessions pruned by the current propagation
+    int failedSession = -1;        // wiped-out session of the last failed propagate()
+    int failedPool = -1;           // or the overloaded pool
+    BitTable blockedRooms;         // time x room, with matchRooms: held rooms no alternating path frees
+    vector<int> classMark;         // class -> stamp of the propagation that last checked it
+    vector<uint64_t> openTimes;    // scratch time row for pool_feasible() past 512 times
+    vector<uint64_t> blockedBefore;  // scratch room row for propagate() with matchRooms
+};
+
+thread_local Propagation prop;
+thread_local vector<uint8_t> componentRooms;  // room -> allotted to this thread's component; empty = all rooms
+
+// A what-if scenario (--scenarios): changes to the loaded problem, applied as
+// an overlay by the thread that solves it while the compiled problem stays
+// shared. Closed (time, resource) pairs start out busy in the occupancy tables
+// with no owning session; growth narrows candidate rooms in the propagation
+// masks. TAs a scenario adds are appended to tas for every thread up front
+// and only become candidates in the scenarios that add them.
+struct Scenario {
+    string name;
+    vector<pair<int, int>> closedRooms;        // (time, room)
+    vector<pair<int, int>> closedInstructors;  // (time, instructor)
+    vector<pair<int, int>> closedTas;          // (time, TA)
+    vector<int> addedTas;
+    int growthPercent = 0;                     // on every section's size
+};
+
+thread_local const Scenario* scenario = nullptr;  // this thread's overlay; null = the problem as loaded
+int loadedTas = INT_MAX;  // TAs from the tables; later ones belong to scenarios
+
+int section_students(int sec) {
+    int n = sections[sec].studentNumber;
+    return scenario ? (n * (100 + scenario->growthPercent) + 99) / 100 : n;
+}
+
+int session_students(int pos) {
+    int n = 0;
+    for (int sec : sessions.sections_of(pos)) n += section_students(sec);
+    return n;
+}
+
+bool ta_enabled(int ta) {
+    return ta < loadedTas || (scenario && find(scenario->addedTas.begin(), scenario->addedTas.end(), ta) != scenario->addedTas.end());
+}
+
+// With --match-rooms the search branches over (time, teacher) only. The rooms
+// of the sessions at one time form a bipartite matching that a placement may
+// rearrange, and a room counts as unavailable only when it is blocked: held by
+// a session that no alternating path can move to a free room. A new session
+// fits at t exactly when one of its candidate rooms is not blocked, and the
+// blocked set does not depend on which complete matching is kept.
+bool matchRooms = false;
+
+// Rooms a session could not get at time t: the busy ones, or with matchRooms
+// the blocked ones.
+const BitTable& unavailable_rooms() { return matchRooms ? prop.blockedRooms : occupancy.rooms; }
+
+bool class_supports(int cls, int t) {
+    const BitTable& busy_rooms = unavailable_rooms();
+    const BitTable& busy_teachers = prop.classIsLecture[cls] ? occupancy.instructors : occupancy.tas;
+    return any_free(prop.classRooms.row(cls), busy_rooms.row(t), busy_rooms.words) &&
+        any_free(prop.classTeachers.row(cls), busy_teachers.row(t), busy_teachers.words);
+}
+
+void remove_time(int session, int t, PruneReason reason) {
+    prop.timeDomain.reset(session, t);
+    --prop.domainSize[session];
+    prop.trail.push_back({ session, t, reason, prop.lastEntry[session] });
+    prop.lastEntry[session] = prop.trail.size() - 1;
+    prop.touched.push_back(session);
+    ++stats.prunings;
+}
+
+void undo_propagation(size_t mark) {
+    while (prop.trail.size() > mark) {
+        const TrailEntry& e = prop.trail.back();
+        prop.timeDomain.set(e.session, e.time);
+        ++prop.domainSize[e.session];
+        prop.lastEntry[e.session] = e.prev;
+        prop.trail.pop_back();
+    }
+}
+
+// Counting check for one pool; false if its unassigned sessions cannot all fit.
+bool pool_feasible(const ResourcePool& pool) {
+    int words = prop.timeDomain.words;
+    uint64_t open_times[8] = {};
+    uint64_t* reach = open_times;
+    if (words > 8) {
+        reach = prop.openTimes.data();
+        fill(reach, reach + words, 0);
+    }
+    int need = 0;
+    for (int j : pool.members) {
+        if (assignments.timeId[j] >= 0) continue;
+        ++need;
+        const uint64_t* dom = prop.timeDomain.row(j);
+        for (int w = 0; w < words; ++w) reach[w] |= dom[w];
+    }
+    if (need == 0) return true;
+
+    const BitTable* busy = nullptr;
+    if (pool.kind == POOL_ROOM) busy = &unavailable_rooms();
+    else if (pool.kind == POOL_INSTRUCTOR) busy = &occupancy.instructors;
+    else if (pool.kind == POOL_TA) busy = &occupancy.tas;
+
+    int capacity = 0;
+    for (int w = 0; w < words && capacity < need; ++w) {
+        for (uint64_t bits = reach[w]; bits && capacity < need; bits &= bits - 1) {
+            int t = w * 64 + __builtin_ctzll(bits);
+            if (!busy) ++capacity;
+            else capacity += count_free(prop.poolMasks.row(pool.maskRow), busy->row(t), busy->words);
+        }
+    }
+    return capacity >= need;
+}
+
+bool check_pools_of(int session) {
+    for (int p : prop.sessionPools[session]) {
+        if (prop.poolStamp[p] == prop.stamp) continue;
+        prop.poolStamp[p] = prop.stamp;
+        if (!pool_feasible(prop.pools[p])) {
+            prop.failedPool = p;
+            return false;
+        }
+    }
+    return true;
+}
+
+void init_propagation() {
+    int n = sessions.size();
+    int num_times = timeSlots.size();
+    int classes = domains.classes();
+    int max_teachers = max(instructors.size(), tas.size());
+
+    prop = Propagation();
+    prop.classRooms.init(classes, rooms.size());
+    prop.classTeachers.init(classes, max_teachers);
+    prop.classIsLecture.assign(classes, 0);
+    prop.classSessions.assign(classes, {});
+    prop.roomClasses.assign(rooms.size(), {});
+    prop.instructorClasses.assign(instructors.size(), {});
+    prop.taClasses.assign(tas.size(), {});
+    prop.sectionSessions.assign(sections.size(), {});
+    for (int pos = 0; pos < n; ++pos) {
+        int cls = domains.sessionClass[pos];
+        prop.classIsLecture[cls] = (sessions.type[pos] == LECTURE);
+        prop.classSessions[cls].push_back(pos);
+        for (int sec : sessions.sections_of(pos)) prop.sectionSessions[sec].push_back(pos);
+    }
+    for (int cls = 0; cls < classes; ++cls) {
+        for (int i = domains.roomStart[cls]; i < domains.roomStart[cls + 1]; ++i) {
+            int r = domains.roomPool[i];
+            if (!componentRooms.empty() && !componentRooms[r]) continue;
+            if (scenario && scenario->growthPercent) {
+                int pos = prop.classSessions[cls][0];
+                if (!match_room(sessions.type[pos], sessions.course[pos], r, session_students(pos))) continue;
+            }
+            prop.classRooms.set(cls, r);
+            prop.roomClasses[r].push_back(cls);
+        }
+        for (int i = domains.teacherStart[cls]; i < domains.teacherStart[cls + 1]; ++i) {
+            int teach = domains.teacherPool[i];
+            if (!prop.classIsLecture[cls] && !ta_enabled(teach)) continue;
+            prop.classTeachers.set(cls, teach);
+            (prop.classIsLecture[cls] ? prop.instructorClasses : prop.taClasses)[teach].push_back(cls);
+        }
+    }
+
+    // Pools: one per section, and one per distinct room set / teacher set.
+    vector<vector<uint64_t>> masks;
+    map<pair<int, vector<uint64_t>>, int> pool_of;
+    auto pool_for = [&](PoolKind kind, const uint64_t* row, int words) {
+        vector<uint64_t> mask(row, row + words);
+        auto it = pool_of.find({ kind, mask });
+        if (it != pool_of.end()) return it->second;
+        int id = prop.pools.size();
+        pool_of.emplace(make_pair((int)kind, mask), id);
+        prop.pools.push_back({ kind, (int)masks.size(), {} });
+        masks.push_back(mask);
+        return id;
+    };
+    prop.sessionPools.assign(n, {});
+    for (int pos = 0; pos < n; ++pos) {
+        int cls = domains.sessionClass[pos];
+        int room_pool = pool_for(POOL_ROOM, prop.classRooms.row(cls), prop.classRooms.words);
+        PoolKind teacher_kind = prop.classIsLecture[cls] ? POOL_INSTRUCTOR : POOL_TA;
+        int teacher_words = prop.classIsLecture[cls] ? occupancy.instructors.words : occupancy.tas.words;
+        int teacher_pool = pool_for(teacher_kind, prop.classTeachers.row(cls), teacher_words);
+        prop.pools[room_pool].members.push_back(pos);
+        prop.pools[teacher_pool].members.push_back(pos);
+        prop.sessionPools[pos] = { room_pool, teacher_pool };
+    }
+    for (int sec = 0; sec < (int)sections.size(); ++sec) {
+        if (prop.sectionSessions[sec].empty()) continue;
+        int id = prop.pools.size();
+        prop.pools.push_back({ POOL_SECTION, -1, prop.sectionSessions[sec] });
+        for (int pos : prop.sectionSessions[sec]) prop.sessionPools[pos].push_back(id);
+    }
+    int mask_cols = max<int>(rooms.size(), max_teachers);
+    prop.poolMasks.init(masks.size(), mask_cols);
+    for (int m = 0; m < (int)masks.size(); ++m) {
+        copy(masks[m].begin(), masks[m].end(), prop.poolMasks.row(m));
+    }
+    prop.poolStamp.assign(prop.pools.size(), 0);
+    prop.blockedRooms.init(num_times, rooms.size());
+    prop.classMark.assign(classes, 0);
+
+    prop.timeDomain.init(n, num_times);
+    prop.domainSize.assign(n, 0);
+    prop.trail.reserve((size_t)n * num_times);
+    prop.lastEntry.assign(n, -1);
+    prop.touched.reserve((size_t)n * num_times);
+    prop.openTimes.assign(prop.timeDomain.words, 0);
+    prop.blockedBefore.assign(prop.blockedRooms.words, 0);
+}
+
+// Initial domains: every time at which the session's section and some candidate
+// room and teacher are free. Returns false if some session has no value at all.
+bool propagate_root() {
+    ++prop.stamp;
+    for (int pos = 0; pos < sessions.size(); ++pos) {
+        if (assignments.timeId[pos] >= 0) continue;
+        int cls = domains.sessionClass[pos];
+        for (int t = 0; t < (int)timeSlots.size(); ++t) {
+            if (sections_busy(pos, t) || !class_supports(cls, t)) continue;
+            prop.timeDomain.set(pos, t);
+            ++prop.domainSize[pos];
+        }
+        if (prop.domainSize[pos] == 0) return false;
+    }
+    for (auto& pool : prop.pools) {
+        if (!pool_feasible(pool)) return false;
+    }
+    return true;
+}
+
+// Recomputes the blocked rooms at t from the current matching: start from the
+// held rooms and unblock every room whose holder has a candidate room that is
+// free or already unblocked, until nothing changes.
+void update_blocked_rooms(int t) {
+    uint64_t* blocked = prop.blockedRooms.row(t);
+    const uint64_t* busy = occupancy.rooms.row(t);
+    const int* owners = occupancy.roomOwner.data() + (size_t)t * rooms.size();
+    int words = prop.blockedRooms.words;
+    copy(busy, busy + words, blocked);
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (int w = 0; w < words; ++w) {
+            for (uint64_t bits = blocked[w]; bits; bits &= bits - 1) {
+                int r = w * 64 + __builtin_ctzll(bits);
+                if (!any_free(prop.classRooms.row(domains.sessionClass[owners[r]]), blocked, words)) continue;
+                blocked[w] &= ~(uint64_t(1) << (r & 63));
+                changed = true;
+            }
+        }
+    }
+}
+
+thread_local vector<int> roomVisit;  // room -> stamp of the augmenting path search that reached it
+thread_local int roomVisitStamp = 0;
+
+// Kuhn's augmenting step: gives session s a candidate room at t, taking a
+// free one if possible and otherwise moving the holder of one elsewhere.
+bool augment_room(int s, int t) {
+    const uint64_t* cand = prop.classRooms.row(domains.sessionClass[s]);
+    uint64_t* busy = occupancy.rooms.row(t);
+    int* owners = occupancy.roomOwner.data() + (size_t)t * rooms.size();
+    for (int w = 0; w < occupancy.rooms.words; ++w) {
+        if (uint64_t bits = cand[w] & ~busy[w]) {
+            int r = w * 64 + __builtin_ctzll(bits);
+            busy[w] |= bits & -bits;
+            owners[r] = s;
+            assignments.roomIndex[s] = r;
+            return true;
+        }
+    }
+    for (int w = 0; w < occupancy.rooms.words; ++w) {
+        for (uint64_t bits = cand[w] & busy[w]; bits; bits &= bits - 1) {
+            int r = w * 64 + __builtin_ctzll(bits);
+            if (roomVisit[r] == roomVisitStamp) continue;
+            roomVisit[r] = roomVisitStamp;
+            if (!augment_room(owners[r], t)) continue;
+            owners[r] = s;
+            assignments.roomIndex[s] = r;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Matches pos, already given a time, to a room; sessions at the same time may
+// change rooms. False if no matching covers them all.
+bool match_room(int pos) {
+    ++roomVisitStamp;
+    return augment_room(pos, assignments.timeId[pos]);
+}
+
+// Prunes unassigned sessions after pos was placed; false on a domain wipe-out
+// or an overloaded pool. Removals stay on the trail either way.
+bool propagate(int pos) {
+    ++stats.propagations;
+    int t = assignments.timeId[pos];
+    prop.touched.clear();
+    prop.failedSession = -1;
+    prop.failedPool = -1;
+
+    auto prune_class = [&](int cls) {
+        if (class_supports(cls, t)) return true;
+        PruneReason reason = any_free(prop.classRooms.row(cls), unavailable_rooms().row(t), occupancy.rooms.words)
+            ? PRUNE_TEACHERS : PRUNE_ROOMS;
+        for (int j : prop.classSessions[cls]) {
+            if (assignments.timeId[j] >= 0 || !prop.timeDomain.test(j, t)) continue;
+            remove_time(j, t, reason);
+            if (prop.domainSize[j] == 0) {
+                prop.failedSession = j;
+                return false;
+            }
+        }
+        return true;
+    };
+
+    for (int sec : sessions.sections_of(pos)) {
+        for (int j : prop.sectionSessions[sec]) {
+            if (assignments.timeId[j] >= 0 || !prop.timeDomain.test(j, t)) continue;
+            remove_time(j, t, PRUNE_SECTION);
+            if (prop.domainSize[j] == 0) {
+                prop.failedSession = j;
+                return false;
+            }
+        }
+    }
+    if (matchRooms) {
+        // Only classes that can use a room blocked by this placement lose t.
+        const uint64_t* blocked = prop.blockedRooms.row(t);
+        uint64_t* before = prop.blockedBefore.data();
+        copy(blocked, blocked + prop.blockedRooms.words, before);
+        update_blocked_rooms(t);
+        ++prop.stamp;
+        for (int w = 0; w < prop.blockedRooms.words; ++w) {
+            for (uint64_t bits = blocked[w] & ~before[w]; bits; bits &= bits - 1) {
+                for (int cls : prop.roomClasses[w * 64 + __builtin_ctzll(bits)]) {
+                    if (prop.classMark[cls] == prop.stamp) continue;
+                    prop.classMark[cls] = prop.stamp;
+                    if (!prune_class(cls)) return false;
+                }
+            }
+        }
+    }
+    else {
+        for (int cls : prop.roomClasses[assignments.roomIndex[pos]]) {
+            if (!prune_class(cls)) return false;
+        }
+    }
+    auto& teacher_classes = (sessions.type[pos] == LECTURE) ? prop.instructorClasses : prop.taClasses;
+    for (int cls : teacher_classes[assignments.teacherIndex[pos]]) {
+        if (!prune_class(cls)) return false;
+    }
+
+    ++prop.stamp;
+    if (!check_pools_of(pos)) return false;
+    for (int j : prop.touched) {
+        if (!check_pools_of(j)) return false;
+    }
+    return true;
+}
+
+void init_occupancy() {
+    int n = timeSlots.size();
+    occupancy.rooms.init(n, rooms.size());
+    occupancy.sections.init(n, sections.size());
+    occupancy.instructors.init(n, instructors.size());
+    occupancy.tas.init(n, tas.size());
+    occupancy.roomOwner.assign((size_t)n * rooms.size(), -1);
+    occupancy.sectionOwner.assign((size_t)n * sections.size(), -1);
+    occupancy.instructorOwner.assign((size_t)n * instructors.size(), -1);
+    occupancy.taOwner.assign((size_t)n * tas.size(), -1);
+    if (scenario) {
+        for (auto [t, r] : scenario->closedRooms) occupancy.rooms.set(t, r);
+        for (auto [t, i] : scenario->closedInstructors) occupancy.instructors.set(t, i);
+        for (auto [t, i] : scenario->closedTas) occupancy.tas.set(t, i);
+    }
+}
+
+BitTable& teacher_table(int pos) {
+    return (sessions.type[pos] == LECTURE) ? occupancy.instructors : occupancy.tas;
+}
+
+int& room_owner(int t, int r) { return occupancy.roomOwner[(size_t)t * rooms.size() + r]; }
+int& section_owner(int t, int sec) { return occupancy.sectionOwner[(size_t)t * sections.size() + sec]; }
+int& teacher_owner(bool lecture, int t, int teach) {
+    return lecture ? occupancy.instructorOwner[(size_t)t * instructors.size() + teach]
+        : occupancy.taOwner[(size_t)t * tas.size() + teach];
+}
+
+void occupy(int pos) {
+    int t = assignments.timeId[pos];
+    occupancy.rooms.set(t, assignments.roomIndex[pos]);
+    teacher_table(pos).set(t, assignments.teacherIndex[pos]);
+    room_owner(t, assignments.roomIndex[pos]) = pos;
+    for (int sec : sessions.sections_of(pos)) {
+        occupancy.sections.set(t, sec);
+        section_owner(t, sec) = pos;
+    }
+    teacher_owner(sessions.type[pos] == LECTURE, t, assignments.teacherIndex[pos]) = pos;
+}
+
+void release(int pos) {
+    int t = assignments.timeId[pos];
+    occupancy.rooms.reset(t, assignments.roomIndex[pos]);
+    for (int sec : sessions.sections_of(pos)) occupancy.sections.reset(t, sec);
+    teacher_table(pos).reset(t, assignments.teacherIndex[pos]);
+}
+
+bool check_constraints(int pos) {
+    int curr_time = assignments.timeId[pos];
+
+    // Room conflict
+    if (occupancy.rooms.test(curr_time, assignments.roomIndex[pos])) return false;
+
+    // Student group (section) conflict
+    if (sections_busy(pos, curr_time)) return false;
+
+    // Teacher conflict
+    if (teacher_table(pos).test(curr_time, assignments.teacherIndex[pos])) return false;
+
+    return true;
+}
+
+// --------------------------------------------------------------------------
+// Conflict explanations, used for backjumping and nogood learning. An
+// explanation is a list of assigned sessions whose placements together cause a
+// failure; solve() keeps one conflict set per search level, stacked in one
+// preallocated array.
+// --------------------------------------------------------------------------
+
+// Conflict set of one search level: earlier sessions, deduplicated through a
+// per-session mark. A deeper level may overwrite marks, which only costs a
+// duplicate entry that normalize() removes later. The set is the tail of
+// items from start on, so only the innermost level adds to it.
+struct ConflictSet {
+    vector<int>& items;
+    size_t start;
+    int level;
+    int stamp;
+    vector<int>& marks;
+
+    void push_back(int j) {
+        if (j < 0 || j >= level || marks[j] == stamp) return;
+        marks[j] = stamp;
+        // make room by dropping duplicates before the array has to grow
+        if (items.size() == items.capacity()) normalize();
+        items.push_back(j);
+    }
+
+    // Sorts the set and drops its duplicates.
+    void normalize() {
+        sort(items.begin() + start, items.end());
+        items.erase(unique(items.begin() + start, items.end()), items.end());
+    }
+    size_t size() const { return items.size() - start; }
+    int operator[](size_t i) const { return items[start + i]; }
+};
+
+// Adds the owners of every busy resource of mask at time t.
+void add_owners(const uint64_t* mask, const BitTable& busy, const vector<int>& owners, int t, ConflictSet& out) {
+    const uint64_t* row = busy.row(t);
+    size_t stride = owners.size() / timeSlots.size();
+    for (int w = 0; w < busy.words; ++w) {
+        for (uint64_t bits = mask[w] & row[w]; bits; bits &= bits - 1) {
+            int idx = w * 64 + __builtin_ctzll(bits);
+            out.push_back(owners[(size_t)t * stride + idx]);
+        }
+    }
+}
+
+// Sessions that keep the rooms of mask from a new session at t: the holders of
+// those rooms, or with matchRooms everyone at t, since a room is blocked by
+// the whole chain of holders an alternating path would have to move.
+void explain_rooms(const uint64_t* mask, int t, ConflictSet& out) {
+    add_owners(matchRooms ? occupancy.rooms.row(t) : mask, occupancy.rooms, occupancy.roomOwner, t, out);
+}
+
+// Sessions whose placements removed times from session j's domain. Trail
+// entries older than since are skipped when the caller already explained them.
+void explain_removals(int j, ConflictSet& out, int since = 0) {
+    int cls = domains.sessionClass[j];
+    bool lecture = prop.classIsLecture[cls];
+    for (int e = prop.lastEntry[j]; e >= since; e = prop.trail[e].prev) {
+        const TrailEntry& entry = prop.trail[e];
+        int t = entry.time;
+        if (entry.reason == PRUNE_SECTION) {
+            for (int sec : sessions.sections_of(j)) {
+                if (occupancy.sections.test(t, sec)) out.push_back(section_owner(t, sec));
+            }
+        }
+        else if (entry.reason == PRUNE_ROOMS) {
+            explain_rooms(prop.classRooms.row(cls), t, out);
+        }
+        else if (entry.reason == PRUNE_TEACHERS) {
+            add_owners(prop.classTeachers.row(cls), lecture ? occupancy.instructors : occupancy.tas,
+                lecture ? occupancy.instructorOwner : occupancy.taOwner, t, out);
+        }
+    }
+}
+
+// Level-local cache for explain_removals(): a session explained into the
+// conflict set with stamp s only needs the entries added since the current
+// value's propagation began.
+thread_local vector<int> removalMarks;  // session -> stamp of the conflict set that holds its removals
+
+void explain_removals_cached(int j, ConflictSet& out, int mark) {
+    explain_removals(j, out, removalMarks[j] == out.stamp ? mark : 0);
+    removalMarks[j] = out.stamp;
+}
+
+// Sessions responsible for an overloaded pool: whatever pruned its members, and
+// whoever holds its resources at the times still open to them. The current
+// value's propagation only removed time t, so the holders at the open times
+// plus t cover every later failure of the same pool on this level.
+thread_local vector<int> poolMarks;  // pool -> stamp of the conflict set holding its resource holders
+thread_local vector<uint64_t> poolReach;  // scratch time row
+
+void explain_pool(int p, ConflictSet& out, int mark, int t_removed) {
+    const ResourcePool& pool = prop.pools[p];
+    vector<uint64_t>& reach = poolReach;
+    fill(reach.begin(), reach.end(), 0);
+    for (int j : pool.members) {
+        if (assignments.timeId[j] < 0) {
+            explain_removals_cached(j, out, mark);
+            const uint64_t* dom = prop.timeDomain.row(j);
+            for (int w = 0; w < (int)reach.size(); ++w) reach[w] |= dom[w];
+        }
+        else if (pool.kind == POOL_SECTION) out.push_back(j);
+    }
+    if (pool.kind == POOL_SECTION || poolMarks[p] == out.stamp) return;
+    poolMarks[p] = out.stamp;
+    reach[t_removed >> 6] |= uint64_t(1) << (t_removed & 63);
+    const uint64_t* mask = prop.poolMasks.row(pool.maskRow);
+    for (int t = 0; t < (int)timeSlots.size(); ++t) {
+        if (!((reach[t >> 6] >> (t & 63)) & 1)) continue;
+        if (pool.kind == POOL_ROOM) explain_rooms(mask, t, out);
+        else if (pool.kind == POOL_INSTRUCTOR) add_owners(mask, occupancy.instructors, occupancy.instructorOwner, t, out);
+        else add_owners(mask, occupancy.tas, occupancy.taOwner, t, out);
+    }
+}
+
+
+// Learned nogoods (see search_arena.h) are sets of (session, time, room,
+// teacher) placements that cannot all hold in one timetable.
+uint64_t placement_key(int session, int t, int r, int teach) {
+    return ((uint64_t)session << 40) | ((uint64_t)t << 28) | ((uint64_t)r << 14) | (uint64_t)teach;
+}
+
+// Key of session j's current placement. With matchRooms the room is left out:
+// rooms are rematched freely and no explanation depends on them.
+uint64_t placement_of(int j) {
+    return placement_key(j, assignments.timeId[j], matchRooms ? 0 : assignments.roomIndex[j], assignments.teacherIndex[j]);
+}
+
+// One level of solve()'s explicit stack: where its conflict set starts, how
+// far the enumeration of its session's values got, and the value being tried.
+struct SearchFrame {
+    bool kept = false;               // placed by repair_timetable(); the search passes through
+    int stamp = 0;                   // of its conflict set
+    size_t conflictStart = 0;        // its conflict set is conflictItems from here on
+    array<int, 3> resume;            // value a resumed checkpoint continues at; resume[0] < 0 = none
+    array<int, 3> prior;             // value a repair tries first; prior[0] < 0 = none
+    bool priorPending = false;
+    int timeIndex = -1;              // enumeration: position in timeOrder,
+    int t = -1, r = -1, teach = -1;  // and the last time, room and teacher; t < 0 = next time
+    array<int, 3> value;             // (time, room, teacher) being tried
+    size_t mark = 0;                 // trail size before its propagation
+};
+
+thread_local NogoodStore nogoods;
+thread_local vector<SearchFrame> frames;     // level -> its frame, one per session
+thread_local vector<int> conflictItems;      // conflict sets of the levels on the path, innermost last
+thread_local vector<int> conflictMarks;      // session -> stamp of the conflict set holding it
+thread_local int conflictStamp = 0;
+thread_local vector<int> failure;            // conflict set of the last failed level
+thread_local vector<int> timeOrder;          // order in which solve() tries times
+thread_local vector<array<int, 3>> preferredPlacement;  // session -> (time, room, teacher) to try first; empty = none
+thread_local uint64_t nodeLimit = UINT64_MAX;           // solve() gives up after this many nodes
+atomic<bool> stopSearch{ false };            // set by the first worker to finish
+
+ConflictSet conflict_set(int pos) {
+    return { conflictItems, frames[pos].conflictStart, pos, frames[pos].stamp, conflictMarks };
+}
+
+// --------------------------------------------------------------------------
+// Budgets and checkpoints. --time-limit and --node-limit bound the search over
+// all threads, and SIGINT or SIGTERM ends it the same way; while any of them
+// is set, every thread records its deepest partial timetable, which is printed
+// when the budget runs out. Search threads poll the budget every few thousand
+// nodes, and the single-threaded search then also writes a checkpoint when
+// one is due: the value tried at every level down to the current one, those
+// levels' conflict sets, the nogoods, the time order and the counters. A run
+// started with the same checkpoint replays that path, skipping the values the
+// levels had already tried, and so carries on where the last one stopped.
+// --------------------------------------------------------------------------
+chrono::steady_clock::time_point searchDeadline = chrono::steady_clock::time_point::max();
+uint64_t searchNodeBudget = UINT64_MAX;   // nodes over all search threads
+atomic<uint64_t> searchNodes{ 0 };        // nodes counted against searchNodeBudget
+atomic<bool> budgetExpired{ false };
+atomic<bool> interruptRequested{ false }; // set by SIGINT and SIGTERM
+
+bool keepPartial = false;  // record partial timetables
+mutex partialLock;
+int partialPlaced = 0;
+AssignmentTable partial;   // deepest partial timetable of any search thread
+
+const char CHECKPOINT_TAG[4] = { 'C', 'A', '1', 'K' };
+const uint32_t CHECKPOINT_VERSION = 2;
+string checkpointPath;     // empty = no checkpoints
+double checkpointSeconds = 60;
+uint64_t checkpointHash = 0;  // source hash of the tables the checkpoint belongs to
+chrono::steady_clock::time_point nextCheckpoint;
+thread_local uint64_t checkpointAllocations = 0; // allocated by this thread's checkpoint writes, left out of its stats
+
+thread_local vector<array<int, 3>> resumePath;    // level -> value its search resumes at
+thread_local vector<vector<int>> resumeConflicts; // level -> its conflict set at the checkpoint
+
+// Keeps this thread's placements if they place more sessions than the best so
+// far. Sessions of other components (times past the last slot) do not count.
+void record_partial() {
+    int placed = 0;
+    for (int t : assignments.timeId) placed += t >= 0 && t < (int)timeSlots.size();
+    lock_guard<mutex> guard(partialLock);
+    if (placed <= partialPlaced) return;
+    partialPlaced = placed;
+    partial = assignments;
+    for (int pos = 0; pos < sessions.size(); ++pos) {
+        if (partial.timeId[pos] >= (int)timeSlots.size()) partial.set(pos, -1, -1, -1);
+    }
+}
+
+// Marks the budget expired once the deadline passed or the run was interrupted.
+bool poll_deadline() {
+    if (chrono::steady_clock::now() >= searchDeadline || interruptRequested.load()) budgetExpired = true;
+    return budgetExpired.load();
+}
+
+// Saves the search with sessions 0..pos on the current path, pos being placed
+// but not yet propagated.
+bool write_checkpoint(int pos) {
+    SnapshotWriter out;
+    out.value<int>(sessions.size());
+    out.value<uint8_t>(matchRooms);
+    out.value(stats);
+    out.array(timeOrder);
+    vector<array<int, 3>> path;
+    vector<int> conflict_start{ 0 }, conflict_items;
+    for (int p = 0; p <= pos; ++p) {
+        // with matchRooms the search tried no room; the matching picked it
+        path.push_back({ assignments.timeId[p], matchRooms ? -1 : assignments.roomIndex[p], assignments.teacherIndex[p] });
+        auto end = p < pos ? conflictItems.begin() + frames[p + 1].conflictStart : conflictItems.end();
+        conflict_items.insert(conflict_items.end(), conflictItems.begin() + frames[p].conflictStart, end);
+        conflict_start.push_back(conflict_items.size());
+    }
+    out.array(path);
+    out.array(conflict_start);
+    out.array(conflict_items);
+    vector<uint32_t> nogood_lengths;
+    vector<uint64_t> nogood_keys;
+    vector<uint8_t> referenced;
+    for (size_t slot = 0; slot < nogoods.size(); ++slot) {
+        auto keys = nogoods.nogood(slot);
+        nogood_lengths.push_back(keys.size());
+        nogood_keys.insert(nogood_keys.end(), keys.begin(), keys.end());
+        referenced.push_back(nogoods.referenced(slot));
+    }
+    out.array(nogood_lengths);
+    out.array(nogood_keys);
+    out.array(referenced);
+    out.value<uint64_t>(nogoods.hand);
+    lock_guard<mutex> guard(partialLock);
+    out.value(partialPlaced);
+    out.array(partial.timeId);
+    out.array(partial.roomIndex);
+    out.array(partial.teacherIndex);
+    return out.save(checkpointPath, CHECKPOINT_TAG, CHECKPOINT_VERSION, checkpointHash);
+}
+
+// Loads checkpointPath into this thread's fresh search state (after
+// init_search()); false if it is missing, stale or from other settings.
+bool read_checkpoint() {
+    SnapshotReader in;
+    if (!in.open(checkpointPath, CHECKPOINT_TAG, CHECKPOINT_VERSION, checkpointHash)) return false;
+    int count = 0;
+    uint8_t match_rooms = 0;
+    SearchStats saved;
+    vector<int> order, conflict_start, conflict_items;
+    vector<array<int, 3>> path;
+    vector<uint32_t> nogood_lengths;
+    vector<uint64_t> nogood_keys;
+    vector<uint8_t> referenced;
+    uint64_t hand = 0;
+    int placed = 0;
+    AssignmentTable best;
+    in.value(count);
+    in.value(match_rooms);
+    in.value(saved);
+    in.array(order);
+    in.array(path);
+    in.array(conflict_start);
+    in.array(conflict_items);
+    in.array(nogood_lengths);
+    in.array(nogood_keys);
+    in.array(referenced);
+    in.value(hand);
+    in.value(placed);
+    in.array(best.timeId);
+    in.array(best.roomIndex);
+    in.array(best.teacherIndex);
+    if (!in.good() || count != sessions.size() || match_rooms != matchRooms || order.size() != timeSlots.size() ||
+        path.empty() || (int)path.size() > sessions.size() || conflict_start.size() != path.size() + 1 ||
+        conflict_start.back() != (int)conflict_items.size()) return false;
+    if (!nogoods.restore(nogood_lengths, nogood_keys, referenced, hand)) return false;
+
+    stats = saved;
+    timeOrder = move(order);
+    resumePath = move(path);
+    resumeConflicts.assign(resumePath.size(), {});
+    for (int p = 0; p < (int)resumePath.size(); ++p) {
+        resumeConflicts[p].assign(conflict_items.begin() + conflict_start[p], conflict_items.begin() + conflict_start[p + 1]);
+    }
+    if ((int)best.timeId.size() == sessions.size()) {
+        partialPlaced = placed;
+        partial = move(best);
+    }
+    return true;
+}
+
+// Called every PUBLISH_MASK + 1 nodes of a search thread with pos placed but
+// not yet propagated: counts the nodes against the budget, checks the
+// deadline and writes a checkpoint when one is due or the budget ran out.
+void poll_search(int pos) {
+    bool expired = (searchNodes += ProgressReporter::PUBLISH_MASK + 1) >= searchNodeBudget;
+    if (expired) budgetExpired = true;
+    expired = poll_deadline();
+    if (checkpointPath.empty()) return;
+    auto now = chrono::steady_clock::now();
+    if (!expired && now < nextCheckpoint) return;
+    // writing the checkpoint is the one thing the search loop allocates for,
+    // and it is left out of the count
+    uint64_t allocations = thread_allocations();
+    if (!write_checkpoint(pos)) cerr << "Could not write checkpoint: " << checkpointPath << endl;
+    checkpointAllocations += thread_allocations() - allocations;
+    nextCheckpoint = now + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(checkpointSeconds));
+}
+
+// Resource behind the last failed propagate(): the reason of the removal that
+// wiped a domain out, or the kind of the overloaded pool.
+ConflictKind failure_kind() {
+    if (prop.failedSession >= 0) {
+        PruneReason reason = prop.trail.back().reason;
+        return reason == PRUNE_SECTION ? CONFLICT_SECTION : reason == PRUNE_ROOMS ? CONFLICT_ROOM : CONFLICT_TEACHER;
+    }
+    PoolKind kind = prop.pools[prop.failedPool].kind;
+    return kind == POOL_SECTION ? CONFLICT_SECTION : kind == POOL_ROOM ? CONFLICT_ROOM : CONFLICT_TEACHER;
+}
+
+// Sets up level pos on the way down: its conflict set, the checkpointed value
+// it resumes at and the prior placement a repair tries first.
+void enter_level(int pos) {
+    SearchFrame& f = frames[pos];
+    f.stamp = ++conflictStamp;
+    ConflictSet conf = conflict_set(pos);
+
+    // Resuming a checkpoint: the values before the saved one were searched
+    // already, and their failures are in the saved conflict set.
+    f.resume = { -1, -1, -1 };
+    if (pos < (int)resumePath.size()) {
+        f.resume = resumePath[pos];
+        for (int j : resumeConflicts[pos]) conf.push_back(j);
+        if (pos + 1 == (int)resumePath.size()) {
+            resumePath.clear();
+            resumeConflicts.clear();
+        }
+    }
+
+    int cls = domains.sessionClass[pos];
+    const BitTable& busy_teachers = sessions.type[pos] == LECTURE ? occupancy.instructors : occupancy.tas;
+    array<int, 3>& prior = f.prior;
+    prior = preferredPlacement.empty() ? array<int, 3>{ -1, -1, -1 } : preferredPlacement[pos];
+    if (matchRooms) prior[1] = -1;
+    if (!(prior[0] >= 0 && prop.timeDomain.test(pos, prior[0]) &&
+        (prior[1] < 0 || (prop.classRooms.test(cls, prior[1]) && !occupancy.rooms.test(prior[0], prior[1]))) &&
+        prop.classTeachers.test(cls, prior[2]) && !busy_teachers.test(prior[0], prior[2]))) prior[0] = -1;
+    f.priorPending = prior[0] >= 0;
+    f.timeIndex = -1;
+    f.t = -1;
+}
+
+// Moves level pos on to its next value; false once there is none. After the
+// prior placement come the times in timeOrder, and at each time the free
+// candidate rooms and teachers in index order; with matchRooms the room is
+// -1 and pos is matched to one instead. Trying a value leaves the domain and
+// the occupancy the enumeration reads as it found them, so it carries on
+// from the last value alone.
+bool next_value(int pos) {
+    SearchFrame& f = frames[pos];
+    if (f.priorPending) {
+        f.priorPending = false;
+        f.value = f.prior;
+        return true;
+    }
+    int cls = domains.sessionClass[pos];
+    const uint64_t* room_mask = prop.classRooms.row(cls);
+    const uint64_t* teacher_mask = prop.classTeachers.row(cls);
+    const BitTable& busy_teachers = sessions.type[pos] == LECTURE ? occupancy.instructors : occupancy.tas;
+    for (;;) {
+        if (f.t < 0) {
+            if (++f.timeIndex == (int)timeOrder.size()) return false;
+            f.t = timeOrder[f.timeIndex];
+            if (!prop.timeDomain.test(pos, f.t)) {
+                f.t = -1;
+                continue;
+            }
+            // candidate rooms and teachers already taken at t are skipped here
+            // and explained once the level is exhausted
+            f.r = matchRooms ? -1 : next_free(room_mask, occupancy.rooms.row(f.t), occupancy.rooms.words, -1);
+            if (!matchRooms && f.r < 0) {
+                f.t = -1;
+                continue;
+            }
+            f.teach = -1;
+        }
+        f.teach = next_free(teacher_mask, busy_teachers.row(f.t), busy_teachers.words, f.teach);
+        if (f.teach < 0) {
+            if (!matchRooms) f.r = next_free(room_mask, occupancy.rooms.row(f.t), occupancy.rooms.words, f.r);
+            if (matchRooms || f.r < 0) f.t = -1;
+            continue;
+        }
+        f.value = { f.t, f.r, f.teach };
+        if (f.value != f.prior) return true;
+    }
+}
+
+// Takes pos back out of the value it tried; with matchRooms the rooms it
+// blocked open again.
+void leave_value(int pos) {
+    undo_propagation(frames[pos].mark);
+    release(pos);
+    if (matchRooms) update_blocked_rooms(frames[pos].value[0]);
+}
+
+// Explains and learns level pos once its values are exhausted, leaving its
+// conflict set in failure.
+void exhaust_level(int pos) {
+    ConflictSet conf = conflict_set(pos);
+    int cls = domains.sessionClass[pos];
+    bool lecture = sessions.type[pos] == LECTURE;
+    const uint64_t* room_mask = prop.classRooms.row(cls);
+    const uint64_t* teacher_mask = prop.classTeachers.row(cls);
+    const BitTable& busy_teachers = lecture ? occupancy.instructors : occupancy.tas;
+    const vector<int>& teacher_owners = lecture ? occupancy.instructorOwner : occupancy.taOwner;
+    const uint64_t* time_domain = prop.timeDomain.row(pos);
+
+    assignments.set(pos, -1, -1, -1);
+    // The trail and occupancy are back to their state on entry, so the removed
+    // times and the holders of skipped rooms and teachers can be explained now.
+    explain_removals(pos, conf);
+    for (int w = 0; w < prop.timeDomain.words; ++w) {
+        for (uint64_t bits = time_domain[w]; bits; bits &= bits - 1) {
+            int t = w * 64 + __builtin_ctzll(bits);
+            // with matchRooms every time left in the domain had a room for pos
+            if (!matchRooms) add_owners(room_mask, occupancy.rooms, occupancy.roomOwner, t, conf);
+            add_owners(teacher_mask, busy_teachers, teacher_owners, t, conf);
+        }
+    }
+    conf.normalize();
+    stats.nogoodsLearned += nogoods.add(conf.size(), [&](size_t i) { return placement_of(conf[i]); });
+    ++stats.backtracks;
+    failure.assign(conflictItems.begin() + conf.start, conflictItems.end());
+}
+
+// Depth-first search in session order with forward checking and
+// conflict-directed backjumping: a failed subtree reports the sessions that
+// caused it, and levels not among them are skipped on the way back up. Each
+// exhausted level is also stored as a nogood. The search runs on an explicit
+// stack of frames, one per session, and only uses memory init_search() set
+// aside; builds that link alloc_counter.cpp count any heap allocation it makes.
+bool solve() {
+    uint64_t allocations = thread_allocations() - checkpointAllocations;
+    auto done = [&](bool found) {
+        stats.allocations += thread_allocations() - checkpointAllocations - allocations;
+        return found;
+    };
+    enum { ENTER, NEXT_VALUE, FAILED } step = ENTER;  // FAILED: level pos failed and failure says why
+    int pos = 0;
+    for (;;) {
+        if (step == ENTER) {
+            if (pos > stats.maxDepth) {
+                stats.maxDepth = pos;  // sessions placed
+                if (keepPartial) record_partial();
+            }
+            if (pos == sessions.size()) return done(true);
+            frames[pos].conflictStart = conflictItems.size();
+            frames[pos].kept = assignments.timeId[pos] >= 0;
+            if (frames[pos].kept) {
+                ++pos;  // kept by repair_timetable()
+                continue;
+            }
+            if (stopSearch.load(memory_order_relaxed) || budgetExpired.load(memory_order_relaxed) || stats.nodes > nodeLimit) {
+                // another worker finished or a budget ran out: an empty conflict
+                // set unwinds every level
+                failure.clear();
+                step = FAILED;
+                continue;
+            }
+            enter_level(pos);
+            step = NEXT_VALUE;
+        }
+        else if (step == FAILED) {
+            do {
+                if (--pos < 0) return done(false);
+            } while (frames[pos].kept);
+            SearchFrame& f = frames[pos];
+            if (!binary_search(failure.begin(), failure.end(), pos)) {
+                // pos played no part in the failure below: jump over it
+                ++stats.backjumps;
+                leave_value(pos);
+                assignments.set(pos, -1, -1, -1);
+                conflictItems.resize(f.conflictStart);
+                continue;
+            }
+            ConflictSet conf = conflict_set(pos);
+            for (int j : failure) conf.push_back(j);
+            leave_value(pos);
+            step = NEXT_VALUE;
+        }
+        else {
+            SearchFrame& f = frames[pos];
+            if (!next_value(pos)) {
+                exhaust_level(pos);
+                conflictItems.resize(f.conflictStart);
+                step = FAILED;
+                continue;
+            }
+            auto [t, r, teach] = f.value;
+            if (f.resume[0] >= 0) {
+                if (f.value != f.resume) continue;
+                f.resume[0] = -1;
+            }
+            assignments.set(pos, t, r, teach);
+            if ((++stats.nodes & ProgressReporter::PUBLISH_MASK) == 0) {
+                if (progress.enabled()) progress.publish(workerId, stats, pos);
+                poll_search(pos);
+            }
+            ConflictSet conf = conflict_set(pos);
+            if (r < 0 && !match_room(pos)) {
+                // not expected while t is in the domain, which already implies a room
+                ++stats.failures[CONFLICT_ROOM];
+                explain_rooms(prop.classRooms.row(domains.sessionClass[pos]), t, conf);
+                continue;
+            }
+            occupy(pos);
+            f.mark = prop.trail.size();
+            bool ok = propagate(pos);
+            if (!ok) {
+                ++stats.failures[failure_kind()];
+                if (prop.failedSession >= 0) explain_removals_cached(prop.failedSession, conf, f.mark);
+                else explain_pool(prop.failedPool, conf, f.mark, t);
+            }
+            else {
+                int nogood = nogoods.violated(placement_of(pos), [](uint64_t key) { return placement_of(key >> 40) == key; });
+                if (nogood >= 0) {
+                    ok = false;
+                    ++stats.failures[CONFLICT_NOGOOD];
+                    for (uint64_t key : nogoods.nogood(nogood)) conf.push_back(key >> 40);
+                }
+            }
+            if (ok) {
+                ++pos;
+                step = ENTER;
+            }
+            else leave_value(pos);
+        }
+    }
+}
+
+// Resets the calling thread's search state. seed 0 keeps times in ascending
+// order; any other seed shuffles the order solve() tries them in.
+void init_search(unsigned seed = 0) {
+    assignments.reset(sessions.size());
+    init_occupancy();
+    init_propagation();
+    // everything solve() touches is sized here, so its loop never allocates
+    frames.resize(sessions.size());
+    // a level's conflict set holds at most the levels above it; deep paths
+    // keep a few hundred each at worst, and untouched pages cost nothing
+    conflictItems.clear();
+    size_t n = sessions.size();
+    conflictItems.reserve(min(n * (n + 1) / 2, 128 * n) + 4096);
+    conflictMarks.assign(sessions.size(), 0);
+    failure.clear();
+    failure.reserve(sessions.size());
+    removalMarks.assign(sessions.size(), 0);
+    poolMarks.assign(prop.pools.size(), 0);
+    poolReach.assign(prop.timeDomain.words, 0);
+    roomVisit.resize(rooms.size());
+    nogoods.clear();
+    if (keepPartial) {
+        lock_guard<mutex> guard(partialLock);
+        if ((int)partial.timeId.size() != sessions.size()) partial.reset(sessions.size());
+    }
+    stats = SearchStats();
+    timeOrder.resize(timeSlots.size());
+    iota(timeOrder.begin(), timeOrder.end(), 0);
+    if (seed) shuffle(timeOrder.begin(), timeOrder.end(), mt19937(seed));
+}
+
+// Final rooms for a timetable found with matchRooms. At every time the
+// sessions are matched again, largest section first, each trying its
+// candidate rooms from the smallest up, so a session takes the tightest room
+// that still leaves a complete matching.
+void assign_tight_rooms() {
+    vector<vector<int>> room_order(domains.classes());
+    for (int cls = 0; cls < domains.classes(); ++cls) {
+        room_order[cls].assign(domains.roomPool.begin() + domains.roomStart[cls], domains.roomPool.begin() + domains.roomStart[cls + 1]);
+        stable_sort(room_order[cls].begin(), room_order[cls].end(), [](int a, int b) { return rooms[a].capacity < rooms[b].capacity; });
+    }
+    vector<vector<int>> at_time(timeSlots.size());
+    for (int pos = 0; pos < sessions.size(); ++pos) at_time[assignments.timeId[pos]].push_back(pos);
+    vector<int> holder(rooms.size(), -1), seen(rooms.size(), 0);
+    int stamp = 0;
+    function<bool(int)> augment = [&](int s) {
+        for (int r : room_order[domains.sessionClass[s]]) {
+            if (seen[r] == stamp) continue;
+            seen[r] = stamp;
+            if (holder[r] >= 0 && !augment(holder[r])) continue;
+            holder[r] = s;
+            assignments.roomIndex[s] = r;
+            return true;
+        }
+        return false;
+    };
+    for (auto& group : at_time) {
+        stable_sort(group.begin(), group.end(), [](int a, int b) {
+            return session_students(a) > session_students(b);
+        });
+        vector<int> previous;
+        for (int pos : group) previous.push_back(assignments.roomIndex[pos]);
+        bool complete = true;
+        for (int pos : group) {
+            ++stamp;
+            complete = complete && augment(pos);
+        }
+        for (int pos : group) {
+            if (assignments.roomIndex[pos] >= 0) holder[assignments.roomIndex[pos]] = -1;
+        }
+        // the search's matching stands if this one somehow came out incomplete
+        if (!complete) {
+            for (int i = 0; i < (int)group.size(); ++i) assignments.roomIndex[group[i]] = previous[i];
+        }
+    }
+}
+
+// --------------------------------------------------------------------------
+// Parallel search. Split mode cuts the top of the solve() tree into tasks, one
+// per combination of times for the first few sessions, and runs them on a
+// work-stealing pool. Portfolio mode runs the whole search once per worker,
+// each with a differently seeded time order. Either way the first worker to
+// find a timetable publishes it and raises stopSearch for the rest.
+// --------------------------------------------------------------------------
+
+struct TaskQueue {
+    mutex lock;
+    deque<vector<int>> tasks;  // times of sessions 0..k-1
+};
+
+vector<TaskQueue> taskQueues;
+AssignmentTable solution;
+
+bool share_section(int a, int b) {
+    for (int sec : sessions.sections_of(a)) {
+        IndexRange other = sessions.sections_of(b);
+        if (find(other.begin(), other.end(), sec) != other.end()) return true;
+    }
+    return false;
+}
+
+// Task prefixes over the root domains, extended one session at a time until
+// there are at least want of them. Prefixes putting a section twice in the
+// same time are dropped.
+vector<vector<int>> split_tasks(int want) {
+    vector<vector<int>> tasks{ {} };
+    for (int pos = 0; pos < sessions.size() && (int)tasks.size() < want; ++pos) {
+        vector<vector<int>> next;
+        for (const auto& prefix : tasks) {
+            for (int t = 0; t < (int)timeSlots.size(); ++t) {
+                if (!prop.timeDomain.test(pos, t)) continue;
+                bool clash = false;
+                for (int j = 0; j < pos && !clash; ++j) {
+                    clash = prefix[j] == t && share_section(j, pos);
+                }
+                if (clash) continue;
+                next.push_back(prefix);
+                next.back().push_back(t);
+            }
+        }
+        tasks = move(next);
+    }
+    return tasks;
+}
+
+// Own queue from the front, otherwise steal from the back of another queue.
+bool next_task(int worker, vector<int>& task) {
+    for (int k = 0; k < (int)taskQueues.size(); ++k) {
+        TaskQueue& queue = taskQueues[(worker + k) % taskQueues.size()];
+        lock_guard<mutex> guard(queue.lock);
+        if (queue.tasks.empty()) continue;
+        if (k == 0) {
+            task = move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+        else {
+            task = move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+        return true;
+    }
+    return false;
+}
+
+// Restricts the first sessions to the task's times; false if that already
+// overloads a pool.
+bool apply_task(const vector<int>& task) {
+    ++prop.stamp;
+    for (int pos = 0; pos < (int)task.size(); ++pos) {
+        for (int t = 0; t < (int)timeSlots.size(); ++t) {
+            if (t != task[pos] && prop.timeDomain.test(pos, t)) remove_time(pos, t, PRUNE_TASK);
+        }
+    }
+    for (int pos = 0; pos < (int)task.size(); ++pos) {
+        if (!check_pools_of(pos)) return false;
+    }
+    return true;
+}
+
+vector<SearchStats> workerStats;  // worker -> its counters once it finished
+
+void search_worker(int worker, bool portfolio) {
+    workerId = worker;
+    init_search(portfolio && worker > 0 ? 123 + worker : 0);
+    bool found = false;
+    if (portfolio) found = propagate_root() && solve();
+    else if (propagate_root()) {
+        vector<int> task;
+        while (!found && !stopSearch.load() && !budgetExpired.load() && next_task(worker, task)) {
+            size_t mark = prop.trail.size();
+            found = apply_task(task) && solve();
+            if (found) break;
+            undo_propagation(mark);
+            // nogoods learned under this task's premises do not hold in others
+            nogoods.clear();
+        }
+    }
+    if (found && !stopSearch.exchange(true)) solution = assignments;
+    workerStats[worker] = stats;
+}
+
+// Runs the workers and copies the winning timetable into this thread's
+// assignments. Expects init_search() and propagate_root() to have succeeded here.
+bool solve_parallel(int threads, bool portfolio) {
+    if (!portfolio) {
+        taskQueues = vector<TaskQueue>(threads);
+        vector<vector<int>> tasks = split_tasks(threads * 8);
+        for (int i = 0; i < (int)tasks.size(); ++i) taskQueues[i % threads].tasks.push_back(move(tasks[i]));
+    }
+    workerStats.assign(threads, {});
+    vector<thread> workers;
+    for (int w = 0; w < threads; ++w) workers.emplace_back(search_worker, w, portfolio);
+    for (auto& worker : workers) worker.join();
+    if (!stopSearch.load()) return false;
+    assignments = solution;
+    return true;
+}
+
+// --------------------------------------------------------------------------
+// Decomposition. Sessions sharing a section or a candidate teacher constrain
+// each other through every placement, so they are joined into one component;
+// components are solved independently by a pool of workers and the timetables
+// merged. Rooms alone do not join components: a room wanted by several is
+// allotted to one of them up front, in proportion to demand. If that partition
+// leaves some component without a timetable within a node budget, the
+// monolithic search runs instead.
+// --------------------------------------------------------------------------
+const int OTHER_COMPONENT = INT_MAX;  // timeId a worker gives sessions outside its component
+const uint64_t PARTITION_NODES_PER_SESSION = 50;  // search budget of a component under a room partition
+
+struct Decomposition {
+    vector<vector<int>> components;  // sessions, largest component first
+    vector<vector<uint8_t>> rooms;   // component -> room -> allotted; empty if no room is wanted twice
+};
+
+// Splits the rooms wanted by several components between them. First every
+// domain class of a component gets one room of its own, classes with the
+// fewest candidates first, picking the free candidate the other components
+// want least. The remaining rooms then go one by one to the component with the
+// highest demand per room already allotted from the same group of
+// interchangeable rooms (a D'Hondt apportionment), where a session adds 1/k to
+// each of its k candidate rooms. owner receives room ->
+// component. Returns a session left with no free candidate, or -1.
+int partition_rooms(Decomposition& d, vector<int>& owner) {
+    int k = d.components.size();
+    vector<vector<double>> demand(k, vector<double>(rooms.size(), 0));
+    vector<double> total_demand(rooms.size(), 0);
+    vector<int> wanting(rooms.size(), 0);
+    vector<array<int, 3>> needs;  // (candidate rooms, component, first session) per component and class
+    for (int c = 0; c < k; ++c) {
+        set<int> classes_seen;
+        for (int pos : d.components[c]) {
+            int cls = domains.sessionClass[pos];
+            int count = domains.roomStart[cls + 1] - domains.roomStart[cls];
+            for (int i = domains.roomStart[cls]; i < domains.roomStart[cls + 1]; ++i) {
+                int r = domains.roomPool[i];
+                if (demand[c][r] == 0) ++wanting[r];
+                demand[c][r] += 1.0 / count;
+                total_demand[r] += 1.0 / count;
+            }
+            if (classes_seen.insert(cls).second) needs.push_back({ count, c, pos });
+        }
+    }
+    if (*max_element(wanting.begin(), wanting.end()) < 2) return -1;
+
+    owner.assign(rooms.size(), -1);
+    sort(needs.begin(), needs.end());
+    for (auto [count, c, pos] : needs) {
+        int cls = domains.sessionClass[pos];
+        int pick = -1;
+        double least = 0;
+        bool covered = false;
+        for (int i = domains.roomStart[cls]; i < domains.roomStart[cls + 1] && !covered; ++i) {
+            int r = domains.roomPool[i];
+            covered = owner[r] == c;
+            double others = total_demand[r] - demand[c][r];
+            if (owner[r] < 0 && (pick < 0 || others < least)) {
+                pick = r;
+                least = others;
+            }
+        }
+        if (covered) continue;
+        if (pick < 0) return pos;
+        owner[pick] = c;
+    }
+    // Rooms used by the same domain classes are interchangeable; apportion each
+    // such group on its own so every component gets its share of every kind.
+    vector<vector<int>> room_classes(rooms.size());
+    for (int cls = 0; cls < domains.classes(); ++cls) {
+        for (int i = domains.roomStart[cls]; i < domains.roomStart[cls + 1]; ++i) room_classes[domains.roomPool[i]].push_back(cls);
+    }
+    map<vector<int>, vector<int>> allotted;  // room classes -> component -> rooms allotted from the group
+    for (int r = 0; r < (int)rooms.size(); ++r) {
+        auto& group = allotted.try_emplace(room_classes[r], k, 0).first->second;
+        if (owner[r] >= 0) ++group[owner[r]];
+    }
+    for (int r = 0; r < (int)rooms.size(); ++r) {
+        if (owner[r] >= 0) continue;
+        vector<int>& group = allotted[room_classes[r]];
+        double best_score = 0;
+        for (int c = 0; c < k; ++c) {
+            double score = demand[c][r] / (group[c] + 1);
+            if (score > best_score) {
+                best_score = score;
+                owner[r] = c;
+            }
+        }
+        if (owner[r] >= 0) ++group[owner[r]];
+    }
+    d.rooms.assign(k, vector<uint8_t>(rooms.size(), 0));
+    for (int r = 0; r < (int)rooms.size(); ++r) {
+        if (owner[r] >= 0) d.rooms[owner[r]][r] = 1;
+    }
+    return -1;
+}
+
+// Connected components of the section/teacher interaction graph with rooms
+// partitioned between them. A session the partition leaves without rooms
+// joins the components owning its candidates, until every session has one.
+Decomposition decompose() {
+    int n = sessions.size();
+    vector<int> parent(n);
+    iota(parent.begin(), parent.end(), 0);
+    auto find = [&](int x) {
+        while (parent[x] != x) x = parent[x] = parent[parent[x]];
+        return x;
+    };
+    auto unite = [&](int a, int b) { parent[find(a)] = find(b); };
+
+    vector<int> section_anchor(sections.size(), -1), instructor_anchor(instructors.size(), -1), ta_anchor(tas.size(), -1);
+    for (int pos = 0; pos < n; ++pos) {
+        for (int sec : sessions.sections_of(pos)) {
+            int& section = section_anchor[sec];
+            if (section < 0) section = pos;
+            else unite(section, pos);
+        }
+        int cls = domains.sessionClass[pos];
+        vector<int>& teacher_anchor = sessions.type[pos] == LECTURE ? instructor_anchor : ta_anchor;
+        for (int i = domains.teacherStart[cls]; i < domains.teacherStart[cls + 1]; ++i) {
+            int& anchor = teacher_anchor[domains.teacherPool[i]];
+            if (anchor < 0) anchor = pos;
+            else unite(anchor, pos);
+        }
+    }
+
+    vector<int> owner;  // room -> component, from the last partition attempt
+    for (;;) {
+        Decomposition d;
+        vector<int> component_of(n, -1);
+        for (int pos = 0; pos < n; ++pos) {
+            int root = find(pos);
+            if (component_of[root] < 0) {
+                component_of[root] = d.components.size();
+                d.components.emplace_back();
+            }
+            d.components[component_of[root]].push_back(pos);
+        }
+        stable_sort(d.components.begin(), d.components.end(), [](const vector<int>& a, const vector<int>& b) { return a.size() > b.size(); });
+        if (d.components.size() < 2) return d;
+        int stranded = partition_rooms(d, owner);
+        if (stranded < 0) return d;
+        int cls = domains.sessionClass[stranded];
+        for (int i = domains.roomStart[cls]; i < domains.roomStart[cls + 1]; ++i) {
+            int c = owner[domains.roomPool[i]];
+            if (c >= 0) unite(stranded, d.components[c][0]);
+        }
+    }
+}
+
+atomic<int> nextComponent{ 0 };
+atomic<bool> componentFailed{ false };
+
+void component_worker(int worker, const Decomposition& d) {
+    workerId = worker;
+    SearchStats total;
+    vector<uint8_t> member(sessions.size());
+    for (int c; !stopSearch.load() && (c = nextComponent++) < (int)d.components.size();) {
+        componentRooms = d.rooms.empty() ? vector<uint8_t>() : d.rooms[c];
+        // A partition can make a component infeasible, which plain search may take
+        // long to prove; past the budget the monolithic search is cheaper.
+        nodeLimit = d.rooms.empty() ? UINT64_MAX : PARTITION_NODES_PER_SESSION * d.components[c].size();
+        init_search();
+        fill(member.begin(), member.end(), 0);
+        for (int pos : d.components[c]) member[pos] = 1;
+        for (int pos = 0; pos < sessions.size(); ++pos) {
+            if (!member[pos]) assignments.set(pos, OTHER_COMPONENT, -1, -1);
+        }
+        bool found = propagate_root() && solve();
+        total.add(stats);
+        if (!found) {
+            if (!stopSearch.exchange(true)) componentFailed = true;
+            break;
+        }
+        for (int pos : d.components[c]) solution.set(pos, assignments.timeId[pos], assignments.roomIndex[pos], assignments.teacherIndex[pos]);
+    }
+    componentRooms.clear();
+    nodeLimit = UINT64_MAX;
+    workerStats[worker] = total;
+}
+
+// Solves the components on up to threads workers and merges their timetables
+// into this thread's assignments; instances that do not split go to the
+// monolithic search. Expects init_search() and propagate_root() to have
+// succeeded here.
+bool solve_decomposed(int threads, bool portfolio) {
+    auto monolithic = [&] { return threads > 1 ? solve_parallel(threads, portfolio) : solve(); };
+    Decomposition d = decompose();
+    if (d.components.size() < 2) return monolithic();
+    cerr << "Decomposed into " << d.components.size() << " components, largest " << d.components[0].size() << " sessions"
+        << (d.rooms.empty() ? "" : ", rooms partitioned") << endl;
+
+    solution.reset(sessions.size());
+    nextComponent = 0;
+    componentFailed = false;
+    int count = min<int>(threads, d.components.size());
+    workerStats.assign(count, {});
+    vector<thread> workers;
+    for (int w = 0; w < count; ++w) workers.emplace_back(component_worker, w, cref(d));
+    for (auto& worker : workers) worker.join();
+    for (const auto& worker : workerStats) stats.add(worker);
+    workerStats.clear();
+    if (!componentFailed) {
+        assignments = solution;
+        return true;
+    }
+    // Components sharing no resource fail only if the whole instance does.
+    if (d.rooms.empty() || budgetExpired.load()) return false;
+    cerr << "A component has no timetable under the room partition; solving monolithically" << endl;
+    stopSearch = false;
+    return monolithic();
+}
+
+// --------------------------------------------------------------------------
+// Soft constraints and local search. Once a feasible timetable exists,
+// simulated annealing over move and swap neighbourhoods lowers a weighted
+// cost of unmet teacher PreferredSlots, idle gaps in a section's day, empty
+// seats in the chosen room and teacher days above MAX_DAILY_LOAD. Hard
+// constraints stay satisfied throughout (moves go through the occupancy
+// tables), and the cost is kept incrementally so a move costs O(1) to score.
+// The weights are in soft_weights.h.
+// --------------------------------------------------------------------------
+
+struct SoftModel {
+    vector<int> slotDay;         // time -> day index
+    vector<int> slotPosition;    // time -> position within its day
+    int days = 0;
+    BitTable preferred;          // teacher key x time
+    vector<uint8_t> hasPreference;
+};
+
+SoftModel soft;
+
+// Per-thread running totals behind the soft cost.
+struct SoftState {
+    vector<uint64_t> sectionDays;  // section x day -> bits of occupied positions
+    vector<int> teacherLoad;       // teacher key x day -> sessions
+    long long cost = 0;
+};
+
+thread_local SoftState softState;
+
+// Instructors first, then TAs, so one table covers both.
+int teacher_key(int pos) {
+    int teach = assignments.teacherIndex[pos];
+    return sessions.type[pos] == LECTURE ? teach : (int)instructors.size() + teach;
+}
+
+// Slot ids or day names separated by commas, semicolons or spaces; "N/A" or
+// unknown tokens mean no preference.
+void parse_preferred_slots(string text, int key) {
+    replace(text.begin(), text.end(), ',', ' ');
+    replace(text.begin(), text.end(), ';', ' ');
+    stringstream ss(text);
+    string token;
+    while (ss >> token) {
+        if (token == "N/A") continue;
+        for_slot_token(timeSlots, token, [&](int t) {
+            soft.preferred.set(key, t);
+            soft.hasPreference[key] = 1;
+        });
+    }
+}
+
+void compile_soft_model() {
+    soft = SoftModel();
+    map<string, int> day_of;
+    vector<int> next_position;
+    for (const auto& ts : timeSlots) {
+        auto it = day_of.emplace(ts.day, (int)day_of.size()).first;
+        if (it->second == (int)next_position.size()) next_position.push_back(0);
+        soft.slotDay.push_back(it->second);
+        soft.slotPosition.push_back(min(next_position[it->second]++, 63));
+    }
+    soft.days = day_of.size();
+    int keys = instructors.size() + tas.size();
+    soft.preferred.init(keys, timeSlots.size());
+    soft.hasPreference.assign(keys, 0);
+    for (int i = 0; i < (int)instructors.size(); ++i) parse_preferred_slots(instructors[i].preferredSlots, i);
+    for (int i = 0; i < (int)tas.size(); ++i) parse_preferred_slots(tas[i].preferredSlots, instructors.size() + i);
+}
+
+long long gap_cost(uint64_t day_mask) {
+    if (!day_mask) return 0;
+    int span = 64 - __builtin_clzll(day_mask) - __builtin_ctzll(day_mask);
+    return (long long)GAP_WEIGHT * (span - __builtin_popcountll(day_mask));
+}
+
+long long load_cost(int load) {
+    return (long long)LOAD_WEIGHT * max(0, load - MAX_DAILY_LOAD);
+}
+
+// Cost that depends on pos alone.
+long long session_cost(int pos) {
+    int key = teacher_key(pos);
+    long long cost = (long long)WASTE_WEIGHT *
+        (rooms[assignments.roomIndex[pos]].capacity - session_students(pos));
+    if (soft.hasPreference[key] && !soft.preferred.test(key, assignments.timeId[pos])) cost += PREFERENCE_WEIGHT;
+    return cost;
+}
+
+// Adds (sign 1) or removes (sign -1) pos's share of the cost.
+void soft_update(int pos, int sign) {
+    int t = assignments.timeId[pos];
+    int day = soft.slotDay[t];
+    for (int sec : sessions.sections_of(pos)) {
+        uint64_t& mask = softState.sectionDays[(size_t)sec * soft.days + day];
+        softState.cost -= gap_cost(mask);
+        mask ^= uint64_t(1) << soft.slotPosition[t];
+        softState.cost += gap_cost(mask);
+    }
+    int& load = softState.teacherLoad[(size_t)teacher_key(pos) * soft.days + day];
+    softState.cost -= load_cost(load);
+    load += sign;
+    softState.cost += load_cost(load) + sign * session_cost(pos);
+}
+
+// Rebuilds occupancy and the soft totals from the current assignments.
+void init_soft_state() {
+    init_occupancy();
+    softState = SoftState();
+    softState.sectionDays.assign((size_t)sections.size() * soft.days, 0);
+    softState.teacherLoad.assign((size_t)(instructors.size() + tas.size()) * soft.days, 0);
+    for (int pos = 0; pos < sessions.size(); ++pos) {
+        occupy(pos);
+        soft_update(pos, 1);
+    }
+}
+
+// Moves pos to (t, r, teach) if that keeps every hard constraint.
+bool try_place(int pos, int t, int r, int teach) {
+    bool lecture = sessions.type[pos] == LECTURE;
+    if (sections_busy(pos, t) || occupancy.rooms.test(t, r) ||
+        (lecture ? occupancy.instructors : occupancy.tas).test(t, teach)) return false;
+    assignments.set(pos, t, r, teach);
+    occupy(pos);
+    soft_update(pos, 1);
+    return true;
+}
+
+void unplace(int pos) {
+    soft_update(pos, -1);
+    release(pos);
+}
+
+// Uniformly random set bit of mask & ~busy, or -1.
+int random_free(const uint64_t* mask, const uint64_t* busy, int words, mt19937& rng) {
+    int count = count_free(mask, busy, words);
+    if (count == 0) return -1;
+    int pick = rng() % count;
+    for (int w = 0; w < words; ++w) {
+        for (uint64_t bits = mask[w] & ~busy[w]; bits; bits &= bits - 1) {
+            if (pick-- == 0) return w * 64 + __builtin_ctzll(bits);
+        }
+    }
+    return -1;
+}
+
+// Simulated annealing for the given number of seconds, starting from the
+// state set up by init_soft_state(); leaves the best timetable found in
+// assignments and returns its cost.
+long long optimize_timetable(double seconds, unsigned seed = 123) {
+    if (sessions.size() == 0) return 0;
+    mt19937 rng(seed);
+    AssignmentTable best = assignments;
+    long long best_cost = softState.cost;
+    double start_temp = 2.0 * (PREFERENCE_WEIGHT + GAP_WEIGHT), end_temp = 0.5;
+    double temp = start_temp;
+    auto start = chrono::steady_clock::now();
+    uniform_real_distribution<double> coin(0.0, 1.0);
+
+    for (long long iter = 0;; ++iter) {
+        if ((iter & 255) == 0) {
+            double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            if (elapsed >= seconds) break;
+            temp = start_temp * pow(end_temp / start_temp, elapsed / seconds);
+        }
+        long long before = softState.cost;
+        int a = rng() % sessions.size();
+        int ta = assignments.timeId[a], ra = assignments.roomIndex[a], ka = assignments.teacherIndex[a];
+
+        if (coin(rng) < 0.5) {
+            // move: a new time, and a random free candidate room and teacher there
+            int cls = domains.sessionClass[a];
+            bool lecture = sessions.type[a] == LECTURE;
+            int t = rng() % timeSlots.size();
+            unplace(a);
+            const BitTable& busy_teachers = lecture ? occupancy.instructors : occupancy.tas;
+            int r = coin(rng) < 0.5 && !occupancy.rooms.test(t, ra) ? ra
+                : random_free(prop.classRooms.row(cls), occupancy.rooms.row(t), occupancy.rooms.words, rng);
+            int k = coin(rng) < 0.5 && !busy_teachers.test(t, ka) ? ka
+                : random_free(prop.classTeachers.row(cls), busy_teachers.row(t), busy_teachers.words, rng);
+            if (r < 0 || k < 0 || !try_place(a, t, r, k)) {
+                try_place(a, ta, ra, ka);
+                continue;
+            }
+            long long delta = softState.cost - before;
+            if (delta > 0 && coin(rng) >= exp(-delta / temp)) {
+                unplace(a);
+                try_place(a, ta, ra, ka);
+                continue;
+            }
+        }
+        else {
+            // swap: exchange the times of two sessions of the same section
+            const auto& mates = prop.sectionSessions[sessions.sectionIndex[a]];
+            int b = mates[rng() % mates.size()];
+            int tb = assignments.timeId[b], rb = assignments.roomIndex[b], kb = assignments.teacherIndex[b];
+            if (b == a || ta == tb) continue;
+            unplace(a);
+            unplace(b);
+            if (!try_place(a, tb, ra, ka)) {
+                try_place(b, tb, rb, kb);
+                try_place(a, ta, ra, ka);
+                continue;
+            }
+            if (!try_place(b, ta, rb, kb)) {
+                unplace(a);
+                try_place(b, tb, rb, kb);
+                try_place(a, ta, ra, ka);
+                continue;
+            }
+            long long delta = softState.cost - before;
+            if (delta > 0 && coin(rng) >= exp(-delta / temp)) {
+                unplace(a);
+                unplace(b);
+                try_place(a, ta, ra, ka);
+                try_place(b, tb, rb, kb);
+                continue;
+            }
+        }
+        if (softState.cost < best_cost) {
+            best_cost = softState.cost;
+            best = assignments;
+        }
+    }
+    assignments = best;
+    return best_cost;
+}
+
+// --------------------------------------------------------------------------
+// Repair. Given a previously printed timetable and changed inputs, placements
+// that are still valid (the session, time, room and teacher still exist, the
+// room and teacher are still candidates, and nothing already kept clashes with
+// them) are kept and fixed. Only the remaining sessions are re-solved. If that
+// fails within the node budget, more sessions are freed in rounds: first the
+// sessions of the same sections, then those held by candidate teachers, then
+// those in candidate rooms, and finally everything. Every freed session tries
+// its previous placement first.
+// --------------------------------------------------------------------------
+
+// Placements from a timetable in print_timetable()'s format, per current
+// session (time -1 when the session is new or its entities are gone).
+vector<array<int, 3>> read_prior_timetable(const string& path) {
+    vector<array<int, 3>> prior(sessions.size(), { -1, -1, -1 });
+    ifstream in(path);
+    if (!in) return {};
+    map<tuple<int, string, int, int, int, int, int>, int> session_of;  // (year, dept, group, section, type, course, instance)
+    for (int i = 0; i < sessions.size(); ++i) {
+        const Section& sec = sections[sessions.sectionIndex[i]];
+        session_of[{ sec.year, sec.dept, sec.groupNumber, sec.sectionNumber, sessions.type[i], sessions.course[i], sessions.instance[i] }] = i;
+    }
+    map<tuple<string, string, string>, int> time_of;
+    for (int t = 0; t < (int)timeSlots.size(); ++t) time_of.emplace(make_tuple(timeSlots[t].day, timeSlots[t].startTime, timeSlots[t].endTime), t);
+    multimap<string, int> instructor_of, ta_of;
+    for (int i = 0; i < (int)instructors.size(); ++i) instructor_of.emplace(instructors[i].name, i);
+    for (int i = 0; i < (int)tas.size(); ++i) ta_of.emplace(tas[i].name, i);
+
+    auto field = [](const string& line, const string& key) {
+        size_t at = line.find(key + ": ");
+        if (at == string::npos) return string();
+        at += key.size() + 2;
+        return line.substr(at, line.find(", ", at) - at);
+    };
+    string header, kind, when, room, teacher, separator;
+    while (getline(in, header) && getline(in, kind) && getline(in, when) && getline(in, room) && getline(in, teacher)) {
+        getline(in, separator);
+        try {
+            int type = field(kind, "Type") == "Lecture" ? LECTURE : field(kind, "Type") == "Tutorial" ? TUTORIAL : LAB;
+            int course = courseCodes.find(field(kind, "Course"));
+            auto it = session_of.find({ stoi(field(header, "Year")), field(header, "Dept"), stoi(field(header, "Group")),
+                stoi(field(header, "Section")), type, course, stoi(field(kind, "Instance")) });
+            if (it == session_of.end()) continue;
+            int pos = it->second;
+            // "Time: <day> <start> - <end>"
+            string span = when.substr(min(when.size(), (size_t)6));
+            size_t space = span.find(' '), dash = span.find(" - ");
+            if (space == string::npos || dash == string::npos) continue;
+            auto time = time_of.find({ span.substr(0, space), span.substr(space + 1, dash - space - 1), span.substr(dash + 3) });
+            int r = roomIds.find(room.substr(min(room.size(), (size_t)6)));
+            if (time == time_of.end() || r < 0) continue;
+            // names need not be unique: take the first candidate teacher with it
+            auto& by_name = type == LECTURE ? instructor_of : ta_of;
+            auto [first, last] = by_name.equal_range(teacher.substr(min(teacher.size(), (size_t)9)));
+            int cls = domains.sessionClass[pos];
+            for (auto k = first; k != last; ++k) {
+                if (prop.classTeachers.test(cls, k->second)) {
+                    prior[pos] = { time->second, r, k->second };
+                    break;
+                }
+            }
+        }
+        catch (const exception&) {
+            // not a timetable entry
+        }
+    }
+    return prior;
+}
+
+// Places every session of keep at its prior placement when it is still valid
+// and clash-free, in session order; returns the sessions left unplaced.
+vector<int> place_kept(const vector<array<int, 3>>& prior, const vector<char>& keep) {
+    vector<int> unplaced;
+    for (int pos = 0; pos < sessions.size(); ++pos) {
+        auto [t, r, teach] = prior[pos];
+        int cls = domains.sessionClass[pos];
+        const BitTable& busy_teachers = sessions.type[pos] == LECTURE ? occupancy.instructors : occupancy.tas;
+        bool valid = keep[pos] && t >= 0 && prop.classRooms.test(cls, r) && prop.classTeachers.test(cls, teach) &&
+            !occupancy.rooms.test(t, r) && !sections_busy(pos, t) && !busy_teachers.test(t, teach);
+        if (!valid) {
+            unplaced.push_back(pos);
+            continue;
+        }
+        assignments.set(pos, t, r, teach);
+        occupy(pos);
+    }
+    return unplaced;
+}
+
+// Repairs prior into a full timetable in assignments; false when even the
+// full re-solve finds none. Each round but the last stops after node_budget
+// nodes.
+bool repair_timetable(const vector<array<int, 3>>& prior, uint64_t node_budget) {
+    vector<char> keep(sessions.size(), 1);
+    init_search();
+    vector<int> invalid = place_kept(prior, keep);
+    int kept = sessions.size() - invalid.size();
+    for (int pos : invalid) keep[pos] = 0;
+
+    // the sections, lecture and tutorial/lab teachers and rooms the invalid sessions could use
+    vector<char> section_hit(sections.size(), 0);
+    BitTable teacher_hit, room_hit;
+    teacher_hit.init(2, max(instructors.size(), tas.size()));
+    room_hit.init(1, rooms.size());
+    for (int pos : invalid) {
+        int cls = domains.sessionClass[pos];
+        for (int sec : sessions.sections_of(pos)) section_hit[sec] = 1;
+        uint64_t* teachers = teacher_hit.row(sessions.type[pos] == LECTURE ? 0 : 1);
+        for (int w = 0; w < prop.classTeachers.words; ++w) teachers[w] |= prop.classTeachers.row(cls)[w];
+        for (int w = 0; w < prop.classRooms.words; ++w) room_hit.row(0)[w] |= prop.classRooms.row(cls)[w];
+    }
+
+    preferredPlacement = prior;
+    SearchStats all_rounds;
+    const char* round_names[] = { "invalid sessions", "their sections", "their teachers", "their rooms", "full re-solve" };
+    bool solved = false;
+    int round = 0;
+    for (; round < 5 && !solved && !budgetExpired.load(); ++round) {
+        for (int pos = 0; pos < sessions.size() && round > 0; ++pos) {
+            auto [t, r, teach] = prior[pos];
+            if (round == 1) {
+                for (int sec : sessions.sections_of(pos)) keep[pos] &= !section_hit[sec];
+            }
+            if (round == 2 && teach >= 0 && teacher_hit.test(sessions.type[pos] == LECTURE ? 0 : 1, teach)) keep[pos] = 0;
+            if (round == 3 && r >= 0 && room_hit.test(0, r)) keep[pos] = 0;
+            if (round == 4) keep[pos] = 0;
+        }
+        init_search();
+        place_kept(prior, keep);
+        nodeLimit = round < 4 ? node_budget : UINT64_MAX;
+        solved = propagate_root() && solve();
+        nodeLimit = UINT64_MAX;
+        all_rounds.add(stats);
+        int freed = count(keep.begin(), keep.end(), 0);
+        cerr << "Repair round " << round << " (" << round_names[round] << "): " << freed << " sessions freed, "
+            << (solved ? "solved" : "failed") << endl;
+    }
+    preferredPlacement.clear();
+    stats = all_rounds;
+    if (!solved) return false;
+
+    int moved = 0;
+    for (int pos = 0; pos < sessions.size(); ++pos) {
+        moved += prior[pos] != array<int, 3>{ assignments.timeId[pos], assignments.roomIndex[pos], assignments.teacherIndex[pos] };
+    }
+    cerr << "Repair: kept " << kept << " of " << sessions.size() << " placements as they were valid, "
+        << moved << " sessions placed differently from the prior timetable" << endl;
+    return true;
+}
+
+// --------------------------------------------------------------------------
+// SAT engine (--engine sat). The compiled domains are handed to sat_engine.h,
+// teachers keyed as instructors followed by TAs, and the model is decoded into
+// assignments. The solver's counters are reported as search counters:
+// decisions as nodes, conflicts as backtracks, learnt clauses as nogoods.
+// --------------------------------------------------------------------------
+void publish_sat_stats(const SatStats& sat) {
+    stats.nodes = sat.decisions;
+    stats.backtracks = sat.conflicts;
+    stats.propagations = sat.propagations;
+    stats.nogoodsLearned = sat.learnt;
+    stats.maxDepth = sat.maxLevel;
+    progress.publish(workerId, stats, sat.maxLevel);
+}
+
+bool solve_sat(uint64_t conflict_limit) {
+    SatTimetable t;
+    t.times = timeSlots.size();
+    t.rooms = rooms.size();
+    t.sections = sections.size();
+    t.teachers = instructors.size() + tas.size();
+    t.sectionStart = sessions.sectionStart;
+    t.sectionPool = sessions.sectionList;
+    t.roomStart.push_back(0);
+    t.teacherStart.push_back(0);
+    for (int pos = 0; pos < sessions.size(); ++pos) {
+        int cls = domains.sessionClass[pos];
+        int offset = sessions.type[pos] == LECTURE ? 0 : instructors.size();
+        t.roomPool.insert(t.roomPool.end(), domains.roomPool.begin() + domains.roomStart[cls], domains.roomPool.begin() + domains.roomStart[cls + 1]);
+        for (int i = domains.teacherStart[cls]; i < domains.teacherStart[cls + 1]; ++i) t.teacherPool.push_back(domains.teacherPool[i] + offset);
+        t.roomStart.push_back(t.roomPool.size());
+        t.teacherStart.push_back(t.teacherPool.size());
+    }
+
+    vector<SatPlacement> placement;
+    SatStats sat;
+    SatResult result = solve_timetable_sat(t, placement, sat, conflict_limit, [](const SatStats& now) {
+        publish_sat_stats(now);
+        return poll_deadline();
+    });
+    publish_sat_stats(sat);
+    cerr << "SAT engine: " << sat.vars << " variables, " << sat.clauses << " clauses, " << (result == SAT_SATISFIABLE ? "satisfiable" : result == SAT_UNSATISFIABLE ? "unsatisfiable" : "unknown")
+        << " after " << sat.conflicts << " conflicts, " << sat.decisions << " decisions, " << sat.restarts << " restarts" << endl;
+    if (result != SAT_SATISFIABLE) return false;
+    for (int pos = 0; pos < sessions.size(); ++pos) {
+        int teacher = placement[pos][2] - (sessions.type[pos] == LECTURE ? 0 : (int)instructors.size());
+        assignments.set(pos, placement[pos][0], placement[pos][1], teacher);
+        occupy(pos);
+    }
+    return true;
+}
+
+// --------------------------------------------------------------------------
+// What-if scenarios (--scenarios FILE). The file names scenarios in brackets,
+// each followed by its changes to the loaded tables, one per line:
+//
+//   # comment
+//   [Building 07 closed on Thursday]
+//   close-building "Building 07" Thursday
+//   [Two more PHY TAs]
+//   add-ta "PHY TA A" "PHY 113 (TUT + LAB)"
+//   add-ta "PHY TA B" "PHY 113 (TUT + LAB)"
+//   [Sections grow 20%]
+//   grow-sections 20
+//
+// close-room ROOM, close-building BUILDING, close-teacher NAME and close-time
+// take days or slot ids, or close for the whole week when given none. add-ta
+// takes a name, qualifications as in the TAs table and optionally preferred
+// slots. The problem is loaded and compiled once; a pool of threads solves the
+// unchanged problem as a baseline and every scenario, each applied as an
+// overlay (see Scenario), and a report compares feasibility, solve time and
+// soft cost.
+// --------------------------------------------------------------------------
+
+// Words separated by blanks; double quotes keep blanks inside a word.
+vector<string> split_words(const string& line) {
+    vector<string> words;
+    string word;
+    bool quoted = false, any = false;
+    for (char c : line) {
+        if (c == '"') {
+            quoted = !quoted;
+            any = true;
+        }
+        else if (!quoted && isspace((unsigned char)c)) {
+            if (any) words.push_back(word);
+            word.clear();
+            any = false;
+        }
+        else {
+            word += c;
+            any = true;
+        }
+    }
+    if (any) words.push_back(word);
+    return words;
+}
+
+// The times named by days or slot ids in words[from..]; every time if none.
+bool parse_times(const vector<string>& words, size_t from, vector<int>& times) {
+    times.clear();
+    if (from == words.size()) {
+        for (int t = 0; t < (int)timeSlots.size(); ++t) times.push_back(t);
+        return true;
+    }
+    for (size_t i = from; i < words.size(); ++i) {
+        size_t before = times.size();
+        for_slot_token(timeSlots, words[i], [&](int t) { times.push_back(t); });
+        if (times.size() == before) return false;
+    }
+    return true;
+}
+
+// Reads the scenarios after a baseline with no changes. TAs they add are
+// appended to tas, so the domains must be compiled again when tas grew.
+bool read_scenarios(const string& path, vector<Scenario>& list) {
+    ifstream in(path);
+    if (!in) {
+        cerr << "Cannot read scenarios: " << path << endl;
+        return false;
+    }
+    loadedTas = tas.size();
+    list.assign(1, Scenario());
+    list[0].name = "baseline";
+    string line;
+    vector<int> times;
+    for (int number = 1; getline(in, line); ++number) {
+        auto fail = [&](const string& message) {
+            cerr << path << ":" << number << ": " << message << endl;
+            return false;
+        };
+        string text = trim(line);
+        if (text.empty() || text[0] == '#') continue;
+        if (text[0] == '[') {
+            if (text.back() != ']') return fail("unterminated scenario name");
+            list.emplace_back();
+            list.back().name = trim(text.substr(1, text.size() - 2));
+            continue;
+        }
+        if (list.size() == 1) return fail("change before the first [scenario]");
+        Scenario& sc = list.back();
+        vector<string> words = split_words(text);
+        const string& op = words[0];
+        if (op == "close-room" || op == "close-building") {
+            if (words.size() < 2) return fail(op + " needs a name");
+            if (!parse_times(words, 2, times)) return fail("unknown day or slot id");
+            bool found = false;
+            for (int r = 0; r < (int)rooms.size(); ++r) {
+                if ((op == "close-room" ? rooms[r].id : rooms[r].building) != words[1]) continue;
+                found = true;
+                for (int t : times) sc.closedRooms.emplace_back(t, r);
+            }
+            if (!found) return fail("no room or building named " + words[1]);
+        }
+        else if (op == "close-teacher") {
+            if (words.size() < 2) return fail("close-teacher needs a name");
+            if (!parse_times(words, 2, times)) return fail("unknown day or slot id");
+            bool found = false;
+            for (int i = 0; i < (int)instructors.size(); ++i) {
+                if (instructors[i].name != words[1]) continue;
+                found = true;
+                for (int t : times) sc.closedInstructors.emplace_back(t, i);
+            }
+            for (int i = 0; i < (int)tas.size(); ++i) {
+                if (tas[i].name != words[1]) continue;
+                found = true;
+                for (int t : times) sc.closedTas.emplace_back(t, i);
+            }
+            if (!found) return fail("no instructor or TA named " + words[1]);
+        }
+        else if (op == "close-time") {
+            if (words.size() < 2) return fail("close-time needs days or slot ids");
+            if (!parse_times(words, 1, times)) return fail("unknown day or slot id");
+            for (int t : times) {
+                for (int r = 0; r < (int)rooms.size(); ++r) sc.closedRooms.emplace_back(t, r);
+            }
+        }
+        else if (op == "add-ta") {
+            if (words.size() < 3 || words.size() > 4) return fail("add-ta takes a name, qualifications and optionally preferred slots");
+            TA ta = { tas.empty() ? 1 : tas.back().id + 1, words[1], words.size() > 3 ? words[3] : "N/A", {} };
+            parse_ta_qualifications(words[2], ta);
+            if (ta.qualifiedCourses.empty()) return fail("no qualifications in " + words[2]);
+            sc.addedTas.push_back(tas.size());
+            tas.push_back(ta);
+        }
+        else if (op == "grow-sections") {
+            if (words.size() != 2 || !all_of(words[1].begin(), words[1].end(), [](unsigned char c) { return isdigit(c) || c == '%'; }))
+                return fail("grow-sections takes a percentage");
+            sc.growthPercent = atoi(words[1].c_str());
+        }
+        else return fail("unknown change " + op);
+    }
+    return true;
+}
+
+struct ScenarioResult {
+    bool solved = false;
+    bool exhausted = false;  // the node budget ran out before an answer
+    double solveMs = 0;
+    uint64_t nodes = 0;
+    long long cost = 0;      // soft cost, after --optimize when given
+    AssignmentTable timetable;
+};
+
+void scenario_worker(int worker, const vector<Scenario>& list, vector<ScenarioResult>& results, atomic<int>& next,
+    uint64_t node_budget, double optimize_seconds) {
+    workerId = worker;
+    SearchStats total;
+    for (int i; (i = next++) < (int)list.size();) {
+        scenario = &list[i];
+        ScenarioResult& result = results[i];
+        auto start = chrono::steady_clock::now();
+        init_search();
+        nodeLimit = node_budget;
+        result.solved = propagate_root() && solve();
+        result.exhausted = !result.solved && stats.nodes > nodeLimit;
+        result.solveMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        result.nodes = stats.nodes;
+        total.add(stats);
+        if (!result.solved) continue;
+        init_soft_state();
+        result.cost = optimize_seconds > 0 ? optimize_timetable(optimize_seconds) : softState.cost;
+        result.timetable = assignments;
+    }
+    scenario = nullptr;
+    nodeLimit = UINT64_MAX;
+    workerStats[worker] = total;
+}
+
+// Solves every scenario on up to threads workers and prints the comparison;
+// returns whether the baseline was solved.
+bool run_scenarios(const vector<Scenario>& list, int threads, uint64_t node_budget, double optimize_seconds) {
+    compile_soft_model();
+    vector<ScenarioResult> results(list.size());
+    atomic<int> next{ 0 };
+    threads = min<int>(threads, list.size());
+    workerStats.assign(threads, {});
+    vector<thread> workers;
+    for (int w = 0; w < threads; ++w) {
+        workers.emplace_back(scenario_worker, w, cref(list), ref(results), ref(next), node_budget, optimize_seconds);
+    }
+    for (auto& worker : workers) worker.join();
+
+    const ScenarioResult& base = results[0];
+    size_t width = 8;
+    for (const auto& sc : list) width = max(width, sc.name.size());
+    cout << left << setw(width) << "Scenario" << right << setw(12) << "Result" << setw(12) << "Solve ms" << setw(12) << "Nodes"
+        << setw(12) << "Soft cost" << setw(12) << "vs base" << setw(8) << "Moved" << '\n';
+    for (size_t i = 0; i < list.size(); ++i) {
+        const ScenarioResult& r = results[i];
+        cout << left << setw(width) << list[i].name << right << setw(12) << (r.solved ? "feasible" : r.exhausted ? "unknown" : "infeasible")
+            << setw(12) << fixed << setprecision(1) << r.solveMs << setw(12) << r.nodes;
+        if (!r.solved) {
+            cout << setw(12) << "-" << setw(12) << "-" << setw(8) << "-" << '\n';
+            continue;
+        }
+        cout << setw(12) << r.cost;
+        if (!base.solved) {
+            cout << setw(12) << "-" << setw(8) << "-" << '\n';
+            continue;
+        }
+        int moved = 0;
+        for (int pos = 0; pos < sessions.size(); ++pos) {
+            moved += r.timetable.timeId[pos] != base.timetable.timeId[pos] || r.timetable.roomIndex[pos] != base.timetable.roomIndex[pos] ||
+                r.timetable.teacherIndex[pos] != base.timetable.teacherIndex[pos];
+        }
+        cout << setw(12) << showpos << r.cost - base.cost << noshowpos << setw(8) << moved << '\n';
+    }
+    return base.solved;
+}
+
+// Sessions without a time (a partial timetable) are listed as unplaced, which
+// read_prior_timetable() skips. A shared lecture lists its sections as 1+2+3.
+void print_timetable() {
+    for (int i = 0; i < sessions.size(); ++i) {
+        SessionType type = sessions.type[i];
+        const Section& sec = sections[sessions.sectionIndex[i]];
+        cout << "Year: " << sec.year << ", Dept: " << sec.dept << ", Group: " << sec.groupNumber << ", Section: ";
+        for (int k : sessions.sections_of(i)) cout << (k == sessions.sectionIndex[i] ? "" : "+") << sections[k].sectionNumber;
+        cout << '\n';
+        cout << "Type: " << session_type_name(type) << ", Course: " << courseCodes.names[sessions.course[i]] << ", Instance: " << sessions.instance[i] << '\n';
+        if (assignments.timeId[i] < 0) {
+            cout << "Time: unplaced\nRoom: -\nTeacher: -\n------------------------\n";
+            continue;
+        }
+        const TimeSlot& ts = timeSlots[assignments.timeId[i]];
+        const Room& rm = rooms[assignments.roomIndex[i]];
+        int teacher = assignments.teacherIndex[i];
+        string teacher_name = (type == LECTURE) ? instructors[teacher].name : tas[teacher].name;
+
+        cout << "Time: " << ts.day << " " << ts.startTime << " - " << ts.endTime << '\n';
+        cout << "Room: " << rm.id << '\n';
+        cout << "Teacher: " << teacher_name << '\n';
+        cout << "------------------------" << '\n';
+    }
+}
+
+// Section, teacher and room views of the timetable under dir (--export).
+bool export_timetable(const string& dir, const ExportOptions& options) {
+    TimetableExport t;
+    for (const auto& ts : timeSlots) t.slots.push_back({ to_string(ts.id), ts.day, ts.startTime, ts.endTime });
+    for (const auto& sec : sections) {
+        string name = sec.faculty + " Y" + to_string(sec.year);
+        if (sec.dept != "N/A") name += " " + sec.dept;
+        t.sections.push_back(name + " G" + to_string(sec.groupNumber) + " S" + to_string(sec.sectionNumber));
+    }
+    // a label per set of sections sharing lectures, listed after the sections
+    vector<int> section_label(sessions.size());
+    map<vector<int>, int> label_of;
+    for (int i = 0; i < sessions.size(); ++i) {
+        IndexRange members = sessions.sections_of(i);
+        vector<int> key(members.begin(), members.end());
+        section_label[i] = key[0];
+        if (key.size() == 1) continue;
+        auto [it, added] = label_of.emplace(key, sections.size() + t.sharedSections.size());
+        section_label[i] = it->second;
+        if (!added) continue;
+        t.sharedSections.push_back(key);
+        string name = t.sections[key[0]];
+        for (size_t k = 1; k < key.size(); ++k) name += "+" + to_string(sections[key[k]].sectionNumber);
+        t.sections.push_back(name);
+    }
+    t.courses = courseCodes.names;
+    for (const auto& rm : rooms) t.rooms.push_back(rm.id);
+    for (const auto& ins : instructors) {
+        t.teachers.push_back(ins.name);
+        t.teacherRoles.push_back("Instructor");
+    }
+    for (const auto& ta : tas) {
+        t.teachers.push_back(ta.name);
+        t.teacherRoles.push_back("TA");
+    }
+    t.sessions.reserve(sessions.size());
+    for (int i = 0; i < sessions.size(); ++i) {
+        SessionType type = sessions.type[i];
+        int teacher = assignments.teacherIndex[i] + (type == LECTURE ? 0 : (int)instructors.size());
+        t.sessions.push_back({ assignments.timeId[i], section_label[i], sessions.course[i], assignments.roomIndex[i], teacher, session_type_name(type) });
+    }
+    size_t skipped = 0;
+    bool ok = write_exports(t, dir, options, skipped);
+    if (skipped) cerr << "Export: " << skipped << " calendar events left out for unreadable days or times" << endl;
+    return ok;
+}
+
+// JSON summary of a run for --stats; path "-" writes to stderr.
+bool write_stats(const string& path, const SearchStats& total, const PhaseTimer& timer, int threads, bool solved) {
+    ofstream file;
+    if (path != "-") file.open(path);
+    ostream& out = path == "-" ? cerr : file;
+    out << "{\n  \"sessions\": " << sessions.size() << ",\n  \"domain_classes\": " << domains.classes()
+        << ",\n  \"threads\": " << threads << ",\n  \"solved\": " << (solved ? "true" : "false") << ",\n  \"phases_ms\": ";
+    timer.write_json(out);
+    out << ",\n  \"search\": ";
+    total.write_json(out);
+    out << "\n}\n";
+    return (bool)out;
+}
+
+int main(int argc, char** argv) {
+    int threads = 1;
+    bool portfolio = false;
+    double optimize_seconds = 0;
+    bool xlsx = false;
+    string snapshot_path;
+    bool timings = false;
+    double progress_seconds = 0;
+    string stats_path;
+    string repair_path;
+    uint64_t repair_budget = 100000;
+    bool decompose_first = false;
+    bool sat_engine = false;
+    uint64_t sat_conflicts = UINT64_MAX;
+    string export_dir;
+    ExportOptions export_options;
+    string scenarios_path;
+    uint64_t scenario_budget = 1000000;
+    double time_limit = 0;
+    export_options.weekStart = time(nullptr) / 86400;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) threads = max(1, atoi(argv[++i]));
+        else if (arg == "--portfolio") portfolio = true;
+        else if (arg == "--decompose") decompose_first = true;
+        else if (arg == "--match-rooms") matchRooms = true;
+        else if (arg == "--section-lectures") sharedLectures = false;
+        else if (arg == "--optimize" && i + 1 < argc) optimize_seconds = atof(argv[++i]);
+        else if (arg == "--xlsx") xlsx = true;
+        else if (arg == "--snapshot" && i + 1 < argc) snapshot_path = argv[++i];
+        else if (arg == "--timings") timings = true;
+        else if (arg == "--progress" && i + 1 < argc) progress_seconds = atof(argv[++i]);
+        else if (arg == "--stats" && i + 1 < argc) stats_path = argv[++i];
+        else if (arg == "--repair" && i + 1 < argc) repair_path = argv[++i];
+        else if (arg == "--repair-budget" && i + 1 < argc) repair_budget = strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--engine" && i + 1 < argc && (string(argv[i + 1]) == "sat" || string(argv[i + 1]) == "backtrack")) sat_engine = string(argv[++i]) == "sat";
+        else if (arg == "--sat-conflicts" && i + 1 < argc) sat_conflicts = strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--export" && i + 1 < argc) export_dir = argv[++i];
+        else if (arg == "--export-format" && i + 1 < argc && parse_export_formats(argv[i + 1], export_options)) ++i;
+        else if (arg == "--export-week" && i + 1 < argc && parse_export_date(argv[i + 1], export_options.weekStart)) ++i;
+        else if (arg == "--time-limit" && i + 1 < argc) time_limit = atof(argv[++i]);
+        else if (arg == "--node-limit" && i + 1 < argc) searchNodeBudget = strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--checkpoint" && i + 1 < argc) checkpointPath = argv[++i];
+        else if (arg == "--checkpoint-every" && i + 1 < argc) checkpointSeconds = atof(argv[++i]);
+        else if (arg == "--scenarios" && i + 1 < argc) scenarios_path = argv[++i];
+        else if (arg == "--scenario-budget" && i + 1 < argc) scenario_budget = strtoull(argv[++i], nullptr, 10);
+        else {
+            cerr << "Usage: " << argv[0] << " [--threads N] [--portfolio] [--decompose] [--match-rooms] [--section-lectures] [--optimize SECONDS] [--xlsx] [--snapshot FILE] [--timings]"
+                << " [--progress SECONDS] [--stats FILE|-] [--repair PRIOR_TIMETABLE] [--repair-budget NODES]"
+                << " [--engine backtrack|sat] [--sat-conflicts N]"
+                << " [--export DIR] [--export-format csv,json,ics|all] [--export-week YYYY-MM-DD]"
+                << " [--time-limit SECONDS] [--node-limit NODES] [--checkpoint FILE] [--checkpoint-every SECONDS]"
+                << " [--scenarios FILE] [--scenario-budget NODES]" << endl;
+            return 1;
+        }
+    }
+
+    if (!scenarios_path.empty() && (!repair_path.empty() || sat_engine || decompose_first || matchRooms || portfolio)) {
+        // scenarios run the plain backtracking search, one thread per scenario
+        cerr << "--repair, --engine sat, --decompose, --match-rooms and --portfolio are ignored with --scenarios" << endl;
+        repair_path.clear();
+        sat_engine = decompose_first = matchRooms = portfolio = false;
+    }
+    if (matchRooms && !repair_path.empty()) {
+        // a repair keeps prior rooms fixed, which rematching would undo
+        cerr << "--match-rooms is ignored with --repair" << endl;
+        matchRooms = false;
+    }
+    if (sat_engine && repair_path.empty() && (threads > 1 || decompose_first || matchRooms)) {
+        // the SAT engine places rooms itself, on one thread, over the whole problem
+        cerr << "--threads, --portfolio, --decompose and --match-rooms are ignored with --engine sat" << endl;
+        threads = 1;
+        decompose_first = matchRooms = false;
+    }
+
+    if (!checkpointPath.empty() && (threads > 1 || decompose_first || !repair_path.empty() || sat_engine || !scenarios_path.empty())) {
+        // a checkpoint holds the path of one plain backtracking search
+        cerr << "--checkpoint is ignored with --threads, --decompose, --repair, --engine sat and --scenarios" << endl;
+        checkpointPath.clear();
+    }
+    if (scenarios_path.empty()) {
+        keepPartial = time_limit > 0 || searchNodeBudget != UINT64_MAX || !checkpointPath.empty();
+        if (time_limit > 0) {
+            searchDeadline = chrono::steady_clock::now() + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(time_limit));
+        }
+    }
+    else searchNodeBudget = UINT64_MAX;  // scenarios have --scenario-budget
+
+    PhaseTimer timer;
+    uint64_t hash = snapshot_path.empty() && checkpointPath.empty() ? 0 : source_hash(xlsx);
+    if (snapshot_path.empty() || !load_snapshot(snapshot_path, hash)) {
+        load_timeslots(*read_table("TimeSlots", xlsx));
+        load_rooms(*read_table("Halls", xlsx));
+        load_instructors(*read_table("Instructor", xlsx));
+        load_tas(*read_table("TAs", xlsx));
+        load_sections(*read_table("Sections", xlsx));
+        load_courses(*read_table("Courses", xlsx));
+        if (!load_room_rules(xlsx)) return 1;
+        timer.lap("load");
+        generate_sessions();
+        compile_domains();
+        if (!snapshot_path.empty() && !save_snapshot(snapshot_path, hash)) {
+            cerr << "Could not write snapshot: " << snapshot_path << endl;
+        }
+        timer.lap("compile");
+    }
+    else {
+        if (!load_room_rules(xlsx)) return 1;
+        timer.lap("load");
+    }
+    if (!scenarios_path.empty()) {
+        vector<Scenario> list;
+        if (!read_scenarios(scenarios_path, list)) return 1;
+        if ((int)tas.size() > loadedTas) compile_domains();
+        timer.lap("compile");
+        progress.start(progress_seconds, threads, sessions.size());
+        bool solved = run_scenarios(list, threads, scenario_budget, optimize_seconds);
+        progress.stop();
+        timer.lap("scenarios");
+        if (!stats_path.empty()) {
+            SearchStats total;
+            for (const auto& worker : workerStats) total.add(worker);
+            if (!write_stats(stats_path, total, timer, threads, solved)) cerr << "Could not write stats: " << stats_path << endl;
+        }
+        return 0;
+    }
+    init_search();
+    if (!checkpointPath.empty()) {
+        checkpointHash = hash;
+        nextCheckpoint = chrono::steady_clock::now() + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(checkpointSeconds));
+        if (read_checkpoint()) cerr << "Resuming from checkpoint " << checkpointPath << " at depth " << resumePath.size() << " after " << stats.nodes << " nodes" << endl;
+    }
+    if (keepPartial) {
+        // stop like an exhausted budget, keeping the partial timetable and checkpoint
+        signal(SIGINT, [](int) { interruptRequested = true; });
+        signal(SIGTERM, [](int) { interruptRequested = true; });
+    }
+
+    progress.start(progress_seconds, threads, sessions.size());
+    bool solved;
+    if (!repair_path.empty()) {
+        vector<array<int, 3>> prior = read_prior_timetable(repair_path);
+        if ((int)prior.size() != sessions.size()) {
+            cerr << "Cannot read prior timetable: " << repair_path << endl;
+            return 1;
+        }
+        solved = repair_timetable(prior, repair_budget);
+    }
+    else if (sat_engine) solved = solve_sat(sat_conflicts);
+    else if (decompose_first) solved = propagate_root() && solve_decomposed(threads, portfolio);
+    else solved = propagate_root() && (threads > 1 ? solve_parallel(threads, portfolio) : solve());
+    if (solved && matchRooms) assign_tight_rooms();
+    progress.stop();
+    if (keepPartial) {
+        signal(SIGINT, SIG_DFL);
+        signal(SIGTERM, SIG_DFL);
+    }
+    // a finished search has nothing left to resume
+    if (!checkpointPath.empty() && !budgetExpired) remove(checkpointPath.c_str());
+    timer.lap("search");
+    if (timings) {
+        cerr << "Timings: sessions=" << sessions.size() << " load_ms=" << timer.get("load") << " compile_ms=" << timer.get("compile")
+            << " solve_ms=" << timer.get("search") << " solved=" << solved << endl;
+    }
+    if (solved) {
+        if (optimize_seconds > 0) {
+            compile_soft_model();
+            init_soft_state();
+            long long initial = softState.cost;
+            long long final_cost = optimize_timetable(optimize_seconds);
+            cerr << "Soft cost: " << initial << " -> " << final_cost << endl;
+            timer.lap("optimize");
+        }
+        print_timetable();
+        cout.flush();
+        timer.lap("output");
+        if (!export_dir.empty()) {
+            if (!export_timetable(export_dir, export_options)) cerr << "Could not write export to " << export_dir << endl;
+            timer.lap("export");
+        }
+    }
+    else if (budgetExpired && partialPlaced > 0) {
+        cerr << "Search budget ran out; the best partial timetable places " << partialPlaced << " of " << sessions.size() << " sessions" << endl;
+        assignments = partial;
+        print_timetable();
+        cout.flush();
+        timer.lap("output");
+    }
+    else {
+        cout << (budgetExpired ? "No timetable found within the search budget." : "No feasible timetable found without conflicts.") << endl;
+        timer.lap("output");
+    }
+
+    if (!stats_path.empty()) {
+        SearchStats total = stats;
+        for (const auto& worker : workerStats) total.add(worker);
+        if (!write_stats(stats_path, total, timer, threads, solved)) cerr << "Could not write stats: " << stats_path << endl;
+    }
+    return 0;
 }
\ No newline at end of file
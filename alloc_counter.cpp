@@ -0,0 +1,22 @@
+// alloc_counter.cpp
+// Opt-in allocation counting for either scheduler. Linking this file in, e.g.
+//   g++ -std=c++17 -O2 -pthread ConsoleApplication1.cpp alloc_counter.cpp -o scheduler
+// replaces the global operator new with one that counts the calling thread's
+// allocations, and its thread_allocations() overrides the weak one in
+// search_stats.h, so SearchStats::allocations shows what the search loop
+// allocated. Builds without it keep the library allocator and report 0.
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+static thread_local uint64_t allocations = 0;
+
+uint64_t thread_allocations() { return allocations; }
+
+void* operator new(std::size_t size) {
+    ++allocations;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
@@ -0,0 +1,467 @@
+// benchmark.cpp
+// Synthetic dataset generator and benchmark harness for ConsoleApplication1.
+// Build: g++ -std=c++17 -O2 benchmark.cpp -o benchmark
+// Run:   ./benchmark generate DIR [generator options]
+//        ./benchmark run [--scheduler PATH] [--ladder 1,2,4,8] [--reps N] [--timeout SECONDS]
+//                        [--work DIR] [--baseline FILE] [--save-baseline FILE] [--tolerance F]
+//                        [--arg SCHEDULER_ARG]... [generator options]
+// Generator options: --scale N (10*N sections per year), --room-scarcity F (session
+// demand over available room-slots, 0..1], --teacher-load F (target share of a
+// teacher's slots in use), --qual-density F (chance a teacher also covers another
+// course of the same year), --days N (1-7), --slots-per-day N (1-8), --seed N.
+// The run command generates one dataset per ladder scale, runs the scheduler
+// --reps times on it with --timings, and reports load/compile/solve percentiles
+// and peak RSS. With --baseline it exits 2 when a scale got slower, bigger or
+// stopped solving beyond the tolerance.
+
+#include <bits/stdc++.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+
+struct GeneratorConfig {
+    int scale = 1;
+    double roomScarcity = 0.5;
+    double teacherLoad = 0.5;
+    double qualDensity = 0.2;
+    int days = 5;
+    int slotsPerDay = 4;
+    unsigned seed = 1;
+};
+
+const char* DAY_NAMES[] = { "Sunday", "Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday" };
+const char* DEPARTMENTS[] = { "CSC", "AID", "CNC", "BIF" };
+const int YEARS = 4;
+// A day's slots start at 9:00, last 90 minutes and begin 105 minutes apart;
+// more than MAX_SLOTS_PER_DAY of them would run past midnight.
+const int DAY_START = 9 * 60, SLOT_MINUTES = 90, SLOT_STEP = 105;
+const int MAX_SLOTS_PER_DAY = (24 * 60 - DAY_START - SLOT_MINUTES) / SLOT_STEP + 1;
+
+// CSV field, quoted when it holds a comma or quote.
+string csv_field(const string& s) {
+    if (s.find_first_of(",\"") == string::npos) return s;
+    string out = "\"";
+    for (char c : s) {
+        if (c == '"') out += '"';
+        out += c;
+    }
+    return out + "\"";
+}
+
+string clock_time(int minutes) {
+    int h = minutes / 60 % 12;
+    char buf[32];
+    snprintf(buf, sizeof buf, "%02d:%02d:00 %s", h == 0 ? 12 : h, minutes % 60, minutes < 12 * 60 ? "AM" : "PM");
+    return buf;
+}
+
+struct GenCourse {
+    int year;
+    string specialization;  // department code or N/A
+    string code;
+    int lec, tut, lab;
+    int sections = 0;       // sections taking the course
+    map<pair<string, int>, int> groups = {};  // (department, group) -> its sections taking the course
+};
+
+// Writes the six input tables in the formats ConsoleApplication1's loaders
+// read, including their forward-filled columns.
+void generate(const string& dir, const GeneratorConfig& cfg) {
+    filesystem::create_directories(dir);
+    mt19937 rng(cfg.seed);
+    auto chance = [&](double p) { return uniform_real_distribution<double>(0, 1)(rng) < p; };
+    int days = clamp(cfg.days, 1, 7);
+    int per_day = clamp(cfg.slotsPerDay, 1, MAX_SLOTS_PER_DAY);
+    int slots = days * per_day;
+
+    ofstream ts(dir + "/TimeSlots.csv");
+    ts << "Day,StartTime,EndTime,TimeSlotID\n";
+    for (int t = 0; t < slots; ++t) {
+        int start = DAY_START + (t % per_day) * SLOT_STEP;
+        ts << DAY_NAMES[t / per_day] << "," << clock_time(start) << "," << clock_time(start + SLOT_MINUTES) << "," << t << "\n";
+    }
+
+    // Courses: six common ones in years 1-2; two common plus four per
+    // department in years 3-4. Year 1 has a physics course with PHY_LAB labs.
+    vector<GenCourse> courses;
+    for (int y = 1; y <= YEARS; ++y) {
+        vector<string> specs;
+        if (y <= 2) specs.assign(6, "N/A");
+        else {
+            specs.assign(2, "N/A");
+            for (const char* d : DEPARTMENTS) specs.insert(specs.end(), 4, d);
+        }
+        for (int c = 0; c < (int)specs.size(); ++c) {
+            string prefix = specs[c] == "N/A" ? (y == 1 && c == 0 ? "PHY" : "GEN") : specs[c];
+            string code = prefix + " " + to_string(y) + to_string(10 + c);
+            courses.push_back({ y, specs[c], code, 1, chance(0.5), chance(0.5) || prefix == "PHY" });
+        }
+    }
+
+    ofstream cs(dir + "/Courses.csv");
+    cs << "Year,Semester,Specialization,CourseCode,Title,LecSlots,TutSlots,LabSlots\n";
+    string prev_spec;
+    for (int i = 0; i < (int)courses.size(); ++i) {
+        const auto& c = courses[i];
+        bool first = i == 0 || courses[i - 1].year != c.year;
+        cs << (first ? to_string(c.year) : "") << "," << (first ? to_string(2 * c.year - 1) : "") << ","
+            << (c.specialization != prev_spec ? c.specialization : "") << "," << c.code << ",Title " << c.code
+            << "," << c.lec << "," << c.tut << "," << c.lab << "\n";
+        prev_spec = c.specialization;
+    }
+
+    ofstream ss(dir + "/Sections.csv");
+    ss << "FacultyName,Year,DepartmentName,GroupNumber,SectionNumber,StudentNumber\n";
+    int per_year = 10 * max(1, cfg.scale);
+    int section_number = 0;
+    string prev_dept;
+    int prev_group = -1;
+    for (int y = 1; y <= YEARS; ++y) {
+        for (int s = 0; s < per_year; ++s) {
+            string dept = y <= 2 ? "N/A" : DEPARTMENTS[s * 4 / per_year];
+            int group = s / 3 + 1;
+            for (auto& c : courses) {
+                if (c.year == y && (c.specialization == "N/A" || c.specialization == dept)) {
+                    ++c.sections;
+                    ++c.groups[{ dept, group }];
+                }
+            }
+            ++section_number;
+            ss << (section_number == 1 ? "CSIT" : "") << "," << (s == 0 ? to_string(y) : "") << ","
+                << (s == 0 || dept != prev_dept ? dept : "") << "," << (s == 0 || group != prev_group ? to_string(group) : "")
+                << "," << section_number << "," << uniform_int_distribution<int>(20, 30)(rng) << "\n";
+            prev_dept = dept;
+            prev_group = group;
+        }
+    }
+
+    // Rooms sized so that demand / (rooms * slots) matches the scarcity. A
+    // group of several sections attends one lecture, which only a hall seats,
+    // so the halls are sized for those lectures and the classrooms for the rest.
+    int room_sessions = 0, hall_sessions = 0, lab_sessions = 0, phy_sessions = 0;
+    for (const auto& c : courses) {
+        for (const auto& [key, n] : c.groups) {
+            room_sessions += c.lec + n * c.tut;
+            if (n > 1) hall_sessions += c.lec;
+        }
+        (c.code.compare(0, 3, "PHY") == 0 ? phy_sessions : lab_sessions) += c.sections * c.lab;
+    }
+    double room_slots = slots * clamp(cfg.roomScarcity, 0.01, 1.0);
+    auto rooms_for = [&](int sessions) { return max(1, (int)ceil(sessions / room_slots)); };
+    ofstream hs(dir + "/Halls.csv");
+    hs << "Building,Space,Capacity (Seats),Type of Space\n,,,\n";
+    int room_count = 0;
+    auto add_rooms = [&](int n, const string& type, int capacity) {
+        for (int i = 0; i < n; ++i, ++room_count) {
+            hs << (room_count % 20 == 0 ? "Building " + to_string(room_count / 20 + 1) : "") << ",R" << room_count
+                << "," << capacity << "," << type << "\n";
+        }
+    };
+    int halls = hall_sessions ? rooms_for(hall_sessions) : 0;
+    add_rooms(max(1, rooms_for(room_sessions) - halls), "Classroom", 40);
+    add_rooms(halls, "Hall", 100);
+    add_rooms(rooms_for(lab_sessions), "Computer Lab", 30);
+    add_rooms(rooms_for(phy_sessions), "PHY_LAB", 30);
+
+    // Teachers: enough primaries per course for the target load, each also
+    // qualified for other courses of its year with probability qualDensity.
+    auto preferred = [&]() {
+        if (!chance(0.3)) return string("N/A");
+        int a = rng() % days, b = rng() % days;
+        return a == b ? string(DAY_NAMES[a]) : string(DAY_NAMES[a]) + ", " + DAY_NAMES[b];
+    };
+    auto teachers_for = [&](int sessions) { return sessions ? max(1, (int)ceil(sessions / (slots * clamp(cfg.teacherLoad, 0.01, 1.0)))) : 0; };
+    ofstream is(dir + "/Instructor.csv");
+    is << "InstructorID,Name,PreferredSlots,QualifiedCourses\n";
+    int id = 0;
+    for (const auto& c : courses) {
+        for (int k = teachers_for(c.sections * c.lec); k > 0; --k) {
+            string quals = c.code;
+            for (const auto& o : courses) {
+                if (&o != &c && o.year == c.year && chance(cfg.qualDensity)) quals += ", " + o.code;
+            }
+            ++id;
+            is << id << ",Dr. Instructor " << id << "," << csv_field(preferred()) << "," << csv_field(quals) << "\n";
+        }
+    }
+    auto roles = [](const GenCourse& c) { return string(c.tut && c.lab ? "TUT + LAB" : c.tut ? "TUT" : "LAB"); };
+    ofstream as(dir + "/TAs.csv");
+    as << "TA_ID,Name,PreferredSlots,QualifiedCourses (with Role)\n";
+    id = 0;
+    for (const auto& c : courses) {
+        if (!c.tut && !c.lab) continue;
+        for (int k = teachers_for(c.sections * (c.tut + c.lab)); k > 0; --k) {
+            string quals = c.code + " (" + roles(c) + ")";
+            for (const auto& o : courses) {
+                if (&o != &c && o.year == c.year && (o.tut || o.lab) && chance(cfg.qualDensity)) quals += ", " + o.code + " (" + roles(o) + ")";
+            }
+            ++id;
+            as << id << ",Eng. TA " << id << "," << csv_field(preferred()) << "," << csv_field(quals) << "\n";
+        }
+    }
+}
+
+// One scheduler run; times in milliseconds, peak RSS in KiB.
+struct RunResult {
+    int sessions = 0;
+    double load = 0, compile = 0, solve = 0, wall = 0;
+    long rssKb = 0;
+    bool solved = false;
+    bool timedOut = false;
+    bool failed = false;  // crashed or printed no timings
+};
+
+RunResult run_once(const string& binary, const vector<string>& extra_args, const string& dir, double timeout) {
+    RunResult result;
+    fflush(stdout);  // or the child flushes our pending output again
+    auto start = chrono::steady_clock::now();
+    pid_t pid = fork();
+    if (pid < 0) {
+        result.failed = true;
+        return result;
+    }
+    if (pid == 0) {
+        if (chdir(dir.c_str()) != 0 || !freopen("bench_out.txt", "w", stdout) || !freopen("bench_err.txt", "w", stderr)) _exit(127);
+        vector<char*> argv{ const_cast<char*>(binary.c_str()), const_cast<char*>("--timings") };
+        for (const auto& a : extra_args) argv.push_back(const_cast<char*>(a.c_str()));
+        argv.push_back(nullptr);
+        execv(binary.c_str(), argv.data());
+        _exit(127);
+    }
+    int status = 0;
+    struct rusage usage = {};
+    for (;;) {
+        pid_t done = wait4(pid, &status, WNOHANG, &usage);
+        if (done == pid) break;
+        if (done < 0) {
+            result.failed = true;
+            return result;
+        }
+        if (chrono::duration<double>(chrono::steady_clock::now() - start).count() > timeout && !result.timedOut) {
+            result.timedOut = true;
+            kill(pid, SIGKILL);
+        }
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+    result.wall = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    result.rssKb = usage.ru_maxrss;
+    if (result.timedOut) return result;
+
+    ifstream err(dir + "/bench_err.txt");
+    string line;
+    bool found = false;
+    while (getline(err, line)) {
+        if (line.compare(0, 9, "Timings: ") != 0) continue;
+        int solved = 0;
+        found = sscanf(line.c_str(), "Timings: sessions=%d load_ms=%lf compile_ms=%lf solve_ms=%lf solved=%d",
+            &result.sessions, &result.load, &result.compile, &result.solve, &solved) == 5;
+        result.solved = solved;
+    }
+    result.failed = !found || !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+    return result;
+}
+
+// Nearest-rank percentile.
+double percentile(vector<double> v, double p) {
+    if (v.empty()) return 0;
+    sort(v.begin(), v.end());
+    size_t rank = (size_t)ceil(p / 100 * v.size());
+    return v[min(v.size(), max<size_t>(rank, 1)) - 1];
+}
+
+const char* PHASES[] = { "load", "compile", "solve", "total" };
+
+struct ScaleSummary {
+    int scale = 0;
+    int sessions = 0;
+    int solved = 0, timedOut = 0, failed = 0, runs = 0;
+    map<string, double> p50, p90, maxMs;
+    long rssKb = 0;
+};
+
+ScaleSummary summarize(int scale, const vector<RunResult>& runs) {
+    ScaleSummary s;
+    s.scale = scale;
+    s.runs = runs.size();
+    map<string, vector<double>> samples;
+    for (const auto& r : runs) {
+        s.solved += r.solved;
+        s.timedOut += r.timedOut;
+        s.failed += r.failed && !r.timedOut;
+        s.rssKb = max(s.rssKb, r.rssKb);
+        s.sessions = max(s.sessions, r.sessions);
+        if (r.timedOut || r.failed) continue;
+        samples["load"].push_back(r.load);
+        samples["compile"].push_back(r.compile);
+        samples["solve"].push_back(r.solve);
+        samples["total"].push_back(r.load + r.compile + r.solve);
+    }
+    for (const char* phase : PHASES) {
+        s.p50[phase] = percentile(samples[phase], 50);
+        s.p90[phase] = percentile(samples[phase], 90);
+        s.maxMs[phase] = percentile(samples[phase], 100);
+    }
+    return s;
+}
+
+void print_summary(const ScaleSummary& s) {
+    printf("%5d %8d %3d/%-3d", s.scale, s.sessions, s.solved, s.runs);
+    for (const char* phase : PHASES) printf(" %9.2f %9.2f %9.2f", s.p50.at(phase), s.p90.at(phase), s.maxMs.at(phase));
+    printf(" %9.1f", s.rssKb / 1024.0);
+    if (s.timedOut) printf("  %d timed out", s.timedOut);
+    if (s.failed) printf("  %d failed", s.failed);
+    printf("\n");
+}
+
+// Baseline file: "scale key value" lines, key = phase p50 in ms, rss_kb or solved.
+bool save_baseline(const string& path, const vector<ScaleSummary>& summaries) {
+    ofstream out(path);
+    out << "# benchmark baseline: scale key value\n";
+    for (const auto& s : summaries) {
+        for (const char* phase : PHASES) out << s.scale << " " << phase << " " << s.p50.at(phase) << "\n";
+        out << s.scale << " rss_kb " << s.rssKb << "\n";
+        out << s.scale << " solved " << s.solved << "\n";
+    }
+    return (bool)out;
+}
+
+// Prints every regression against the baseline and returns how many there
+// were, or -1 when the baseline cannot be read.
+// Times get an absolute slack of 1 ms on top of the relative tolerance so that
+// sub-millisecond phases do not flap.
+int check_baseline(const string& path, const vector<ScaleSummary>& summaries, double tolerance) {
+    ifstream in(path);
+    if (!in) {
+        fprintf(stderr, "Cannot read baseline %s\n", path.c_str());
+        return -1;
+    }
+    map<pair<int, string>, double> base;
+    string line;
+    while (getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        istringstream fields(line);
+        int scale;
+        string key;
+        double value;
+        if (fields >> scale >> key >> value) base[{ scale, key }] = value;
+    }
+    int regressions = 0;
+    auto report = [&](int scale, const string& key, double was, double now) {
+        printf("REGRESSION scale %d %s: %.2f -> %.2f\n", scale, key.c_str(), was, now);
+        ++regressions;
+    };
+    for (const auto& s : summaries) {
+        for (const char* phase : PHASES) {
+            auto it = base.find({ s.scale, phase });
+            if (it != base.end() && s.p50.at(phase) > it->second * (1 + tolerance) + 1.0) report(s.scale, string(phase) + " p50 ms", it->second, s.p50.at(phase));
+        }
+        auto rss = base.find({ s.scale, "rss_kb" });
+        if (rss != base.end() && s.rssKb > rss->second * (1 + tolerance)) report(s.scale, "rss_kb", rss->second, s.rssKb);
+        auto solved = base.find({ s.scale, "solved" });
+        if (solved != base.end() && s.solved < solved->second) report(s.scale, "solved", solved->second, s.solved);
+    }
+    return regressions;
+}
+
+void usage(const char* prog) {
+    fprintf(stderr,
+        "Usage: %s generate DIR [--scale N] [--room-scarcity F] [--teacher-load F] [--qual-density F]\n"
+        "          [--days N] [--slots-per-day N] [--seed N]\n"
+        "       %s run [--scheduler PATH] [--ladder 1,2,4,8] [--reps N] [--timeout SECONDS] [--work DIR]\n"
+        "          [--baseline FILE] [--save-baseline FILE] [--tolerance F] [--arg SCHEDULER_ARG]...\n"
+        "          [generator options]\n", prog, prog);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        usage(argv[0]);
+        return 1;
+    }
+    string command = argv[1];
+    GeneratorConfig cfg;
+    string dir, scheduler = "./ConsoleApplication1", work = "bench_work", baseline, save_to;
+    vector<int> ladder{ 1, 2, 4, 8 };
+    vector<string> extra_args;
+    int reps = 5;
+    double timeout = 60, tolerance = 0.25;
+    for (int i = 2; i < argc; ++i) {
+        string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--scale" && has_value) cfg.scale = atoi(argv[++i]);
+        else if (arg == "--room-scarcity" && has_value) cfg.roomScarcity = atof(argv[++i]);
+        else if (arg == "--teacher-load" && has_value) cfg.teacherLoad = atof(argv[++i]);
+        else if (arg == "--qual-density" && has_value) cfg.qualDensity = atof(argv[++i]);
+        else if (arg == "--days" && has_value) cfg.days = atoi(argv[++i]);
+        else if (arg == "--slots-per-day" && has_value) cfg.slotsPerDay = atoi(argv[++i]);
+        else if (arg == "--seed" && has_value) cfg.seed = atoi(argv[++i]);
+        else if (arg == "--scheduler" && has_value) scheduler = argv[++i];
+        else if (arg == "--reps" && has_value) reps = max(1, atoi(argv[++i]));
+        else if (arg == "--timeout" && has_value) timeout = atof(argv[++i]);
+        else if (arg == "--work" && has_value) work = argv[++i];
+        else if (arg == "--baseline" && has_value) baseline = argv[++i];
+        else if (arg == "--save-baseline" && has_value) save_to = argv[++i];
+        else if (arg == "--tolerance" && has_value) tolerance = atof(argv[++i]);
+        else if (arg == "--arg" && has_value) extra_args.push_back(argv[++i]);
+        else if (arg == "--ladder" && has_value) {
+            ladder.clear();
+            stringstream ss(argv[++i]);
+            string step;
+            while (getline(ss, step, ',')) ladder.push_back(max(1, atoi(step.c_str())));
+        }
+        else if (command == "generate" && dir.empty() && arg[0] != '-') dir = arg;
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (cfg.slotsPerDay < 1 || cfg.slotsPerDay > MAX_SLOTS_PER_DAY) {
+        fprintf(stderr, "--slots-per-day must be 1 to %d; more slots end past midnight\n", MAX_SLOTS_PER_DAY);
+        return 1;
+    }
+    if (command == "generate" && !dir.empty()) {
+        generate(dir, cfg);
+        return 0;
+    }
+    if (command != "run") {
+        usage(argv[0]);
+        return 1;
+    }
+
+    error_code ec;
+    string binary = filesystem::absolute(scheduler, ec).string();
+    if (ec || access(binary.c_str(), X_OK) != 0) {
+        fprintf(stderr, "Scheduler not executable: %s\n", scheduler.c_str());
+        return 1;
+    }
+    printf("%5s %8s %7s", "scale", "sessions", "solved");
+    for (const char* phase : PHASES) printf(" %9s %9s %9s", (string(phase) + "50").c_str(), "p90", "max");
+    printf(" %9s\n", "rss MB");
+    vector<ScaleSummary> summaries;
+    for (int scale : ladder) {
+        string data = work + "/scale" + to_string(scale);
+        GeneratorConfig at = cfg;
+        at.scale = scale;
+        generate(data, at);
+        vector<RunResult> runs;
+        for (int r = 0; r < reps; ++r) runs.push_back(run_once(binary, extra_args, data, timeout));
+        summaries.push_back(summarize(scale, runs));
+        print_summary(summaries.back());
+        fflush(stdout);
+    }
+
+    if (!save_to.empty() && !save_baseline(save_to, summaries)) {
+        fprintf(stderr, "Cannot write baseline %s\n", save_to.c_str());
+        return 1;
+    }
+    if (!baseline.empty()) {
+        int regressions = check_baseline(baseline, summaries, tolerance);
+        if (regressions < 0) return 1;
+        if (regressions) return 2;
+        printf("No regressions against %s\n", baseline.c_str());
+    }
+    return 0;
+}
@@ -0,0 +1,165 @@
+// csv_reader.h
+// Zero-copy CSV reader shared by both schedulers. The file is memory-mapped and
+// split in a single pass into string_view cells over the mapping, following
+// RFC 4180: quoted fields may hold commas, line breaks and "" escapes. Spaces
+// and tabs around a field are dropped, CRLF line ends and a UTF-8 BOM are
+// accepted, and blank lines are skipped. Only fields containing "" escapes
+// are copied, into one scratch buffer sized once from the file.
+#pragma once
+
+#include <bits/stdc++.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Read-only memory mapping of a whole file; size 0 for an empty file.
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept { *this = std::move(other); }
+    MappedFile& operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            unmap();
+            mapping = std::exchange(other.mapping, nullptr);
+            length = std::exchange(other.length, 0);
+        }
+        return *this;
+    }
+    ~MappedFile() { unmap(); }
+
+    bool open(const std::string& path) {
+        unmap();
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        bool ok = fstat(fd, &st) == 0;
+        if (ok && st.st_size > 0) {
+            void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            ok = p != MAP_FAILED;
+            if (ok) {
+                mapping = p;
+                length = st.st_size;
+                madvise(p, length, MADV_SEQUENTIAL);
+            }
+        }
+        ::close(fd);
+        return ok;
+    }
+    const char* data() const { return static_cast<const char*>(mapping); }
+    size_t size() const { return length; }
+
+private:
+    void* mapping = nullptr;
+    size_t length = 0;
+
+    void unmap() {
+        if (mapping) munmap(mapping, length);
+        mapping = nullptr;
+        length = 0;
+    }
+};
+
+// One record; out-of-range cells read as empty.
+struct CsvRow {
+    const std::string_view* cells = nullptr;
+    size_t count = 0;
+
+    size_t size() const { return count; }
+    std::string_view operator[](size_t i) const { return i < count ? cells[i] : std::string_view(); }
+};
+
+// Records as string_view cells over storage owned by the producer (a mapped
+// CSV here, a decoded workbook in xlsx_reader.h).
+struct CsvTable {
+    std::vector<std::string_view> cells;
+    std::vector<size_t> rowStart{ 0 };  // row -> its first cell, plus an end marker
+
+    CsvTable() = default;
+    CsvTable(CsvTable&&) = default;
+    CsvTable& operator=(CsvTable&&) = default;
+    virtual ~CsvTable() = default;
+    size_t rows() const { return rowStart.size() - 1; }
+    bool empty() const { return rows() == 0; }
+    CsvRow operator[](size_t r) const { return { cells.data() + rowStart[r], rowStart[r + 1] - rowStart[r] }; }
+    void end_row() { rowStart.push_back(cells.size()); }
+};
+
+class CsvFile : public CsvTable {
+public:
+    // Maps and parses path; false if it cannot be opened. An empty file is
+    // an empty table.
+    bool open(const std::string& path) {
+        cells.clear();
+        rowStart.assign(1, 0);
+        if (!file.open(path)) return false;
+        parse(file.data(), file.size());
+        return true;
+    }
+
+private:
+    MappedFile file;
+    std::unique_ptr<char[]> scratch;  // unescaped copies of fields with ""
+
+    static bool blank(char c) { return c == ' ' || c == '\t'; }
+
+    void parse(const char* data, size_t size) {
+        size_t i = 0;
+        if (size >= 3 && memcmp(data, "\xEF\xBB\xBF", 3) == 0) i = 3;
+        char* out = nullptr;  // next free byte of scratch
+        while (i < size) {
+            size_t first_cell = cells.size();
+            bool quoted_any = false;
+            for (;;) {
+                while (i < size && blank(data[i])) ++i;
+                std::string_view cell;
+                if (i < size && data[i] == '"') {
+                    quoted_any = true;
+                    size_t begin = ++i;
+                    bool escaped = false;
+                    while (i < size && (data[i] != '"' || (i + 1 < size && data[i + 1] == '"'))) {
+                        if (data[i] == '"') {
+                            escaped = true;
+                            ++i;
+                        }
+                        ++i;
+                    }
+                    if (!escaped) cell = std::string_view(data + begin, i - begin);
+                    else {
+                        if (!scratch) {
+                            scratch.reset(new char[size]);
+                            out = scratch.get();
+                        }
+                        char* start = out;
+                        for (size_t k = begin; k < i; ++k) {
+                            *out++ = data[k];
+                            if (data[k] == '"') ++k;
+                        }
+                        cell = std::string_view(start, out - start);
+                    }
+                    if (i < size) ++i;  // closing quote
+                    while (i < size && data[i] != ',' && data[i] != '\n' && data[i] != '\r') ++i;
+                }
+                else {
+                    size_t begin = i;
+                    while (i < size && data[i] != ',' && data[i] != '\n' && data[i] != '\r') ++i;
+                    size_t end = i;
+                    while (end > begin && blank(data[end - 1])) --end;
+                    cell = std::string_view(data + begin, end - begin);
+                }
+                cells.push_back(cell);
+                if (i < size && data[i] == ',') {
+                    ++i;
+                    continue;
+                }
+                break;
+            }
+            if (i < size && data[i] == '\r') ++i;
+            if (i < size && data[i] == '\n') ++i;
+            if (cells.size() == first_cell + 1 && cells.back().empty() && !quoted_any) cells.pop_back();
+            else end_row();
+        }
+    }
+};
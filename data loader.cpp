@@ -1,445 +1,1180 @@
-// timetable_scheduler.cpp
-// Single-file C++17 program to load CSVs and solve a course-timetabling CSP
-// Provided CSV filenames (place them next to the executable):
-// Courses.csv, Instructor.csv, TAs.csv, Halls.csv, TimeSlots.csv, Sections.csv
-// Build: g++ -std=c++17 timetable_scheduler.cpp -O2 -o scheduler
-// Run: ./scheduler
-
-#include <bits/stdc++.h>
-using namespace std;
-
-// --------------------------
-// CSV parsing utility
-// --------------------------
-static vector<string> splitCSVLine(const string& line, char delim = ',') {
-    vector<string> out;
-    string cur;
-    bool inQuotes = false;
-    for (size_t i = 0; i < line.size(); ++i) {
-        char c = line[i];
-        if (c == '\"') {
-            if (inQuotes && i + 1 < line.size() && line[i + 1] == '\"') {
-                // escaped quote
-                cur.push_back('\"');
-                ++i;
-            }
-            else {
-                inQuotes = !inQuotes;
-            }
-        }
-        else if (c == delim && !inQuotes) {
-            out.push_back(cur);
-            cur.clear();
-        }
-        else {
-            cur.push_back(c);
-        }
-    }
-    out.push_back(cur);
-    return out;
-}
-
-vector<vector<string>> loadCSV(const string& filename) {
-    ifstream f(filename);
-    if (!f.is_open()) {
-        cerr << "Failed to open " << filename << "\n";
-        return {};
-    }
-    vector<vector<string>> rows;
-    string line;
-    while (getline(f, line)) {
-        if (line.size() == 0) continue;
-        auto r = splitCSVLine(line);
-        rows.push_back(r);
-    }
-    return rows;
-}
-
-// --------------------------
-// Data model
-// --------------------------
-struct Course {
-    string id; // course code
-    string name;
-    // other attributes if present
-};
-
-struct TimeSlot {
-    string id; // unique id
-    string day; // e.g., Mon
-    string start; // e.g., 08:00
-    string end;   // e.g., 09:30
-};
-
-struct Room {
-    string id;
-    string type; // Classroom, ComputerLab, PHY_LAB, etc.
-    int capacity;
-};
-
-struct Instructor {
-    string id;
-    string name;
-    // qualifications: which courses or types (e.g., can teach LEC/TUT/LAB)
-    unordered_set<string> qualCourses;
-};
-
-struct TA {
-    string id;
-    string name;
-    unordered_set<string> qualRoles; // e.g., TUT, LAB
-    unordered_set<string> qualCourses; // which courses they can assist
-};
-
-struct Section {
-    string id; // e.g., CS101-1
-    string courseId;
-    int size; // number of students
-    // which session types required: LEC, TUT, LAB
-    vector<string> sessionTypes;
-};
-
-// Variable to assign: one session instance
-struct SessionVar {
-    string id; // unique var id
-    string sectionId;
-    string courseId;
-    string type; // LEC, TUT, LAB
-    int neededCapacity;
-};
-
-struct Assignment {
-    string timeslotId;
-    string roomId;
-    string instructorId; // can be empty for TAs-only sessions
-    string taId; // optional
-};
-
-// --------------------------
-// Global data
-// --------------------------
-vector<Course> courses;
-vector<TimeSlot> timeslots;
-vector<Room> rooms;
-vector<Instructor> instructors;
-vector<TA> tas;
-vector<Section> sections;
-vector<SessionVar> variables;
-
-unordered_map<string, Course*> courseById;
-unordered_map<string, TimeSlot*> timeslotById;
-unordered_map<string, Room*> roomById;
-unordered_map<string, Instructor*> instrById;
-unordered_map<string, TA*> taById;
-unordered_map<string, Section*> sectionById;
-
-// Domains per variable: list of possible assignments (timeslot, room, instr, ta)
-using DomainItem = Assignment;
-vector<vector<DomainItem>> domains;
-
-// Current assignment
-vector<optional<Assignment>> currentAssign;
-
-// Conflict trackers for O(1) checks
-unordered_map<string, unordered_set<string>> instrBusy; // timeslotId -> set of instrId
-unordered_map<string, unordered_set<string>> taBusy;    // timeslotId -> set of taId
-unordered_map<string, unordered_set<string>> roomBusy;  // timeslotId -> set of roomId
-unordered_map<string, unordered_set<string>> sectionBusy; // timeslotId -> set of sectionId
-
-// Quick utility
-bool roomMatchesType(const Room& r, const string& requiredType) {
-    string t = r.type;
-    // normalize
-    auto normalize = [&](string s) {
-        for (auto& c : s) c = toupper((unsigned char)c);
-        return s;
-        };
-    string R = normalize(t);
-    string Q = requiredType;
-    for (auto& c : Q) c = toupper((unsigned char)c);
-    // simple matching rules
-    if (Q.find("LAB") != string::npos) {
-        return R.find("LAB") != string::npos || R.find("COMPUTER") != string::npos || R.find("PHY") != string::npos;
-    }
-    else if (Q.find("CLASS") != string::npos || Q.find("LECT") != string::npos) {
-        return R.find("CLASS") != string::npos || R.find("LECT") != string::npos;
-    }
-    return R == Q;
-}
-
-// --------------------------
-// Domain generation
-// --------------------------
-void buildDomains() {
-    domains.clear();
-    domains.resize(variables.size());
-    for (size_t i = 0; i < variables.size(); ++i) {
-        auto& v = variables[i];
-        // determine required room type based on v.type
-        string requiredRoomType = (v.type == "LAB") ? "LAB" : "CLASSROOM";
-        // candidate rooms: capacity >= neededCapacity and matching type
-        vector<Room*> candidateRooms;
-        for (auto& r : rooms) { if (r.capacity >= v.neededCapacity && roomMatchesType(r, requiredRoomType)) candidateRooms.push_back(&r); }
-        // candidate timeslots: all
-        for (auto& ts : timeslots) {
-            for (auto* rptr : candidateRooms) {
-                // candidate instructors or TAs depending on session type
-                if (v.type == "LEC") {
-                    for (auto& ins : instructors) {
-                        // If instructor qualified for the course or no qualification data -> allow
-                        if (ins.qualCourses.empty() || ins.qualCourses.count(v.courseId)) {
-                            domains[i].push_back({ ts.id, rptr->id, ins.id, string() });
-                        }
-                    }
-                }
-                else if (v.type == "TUT") {
-                    // require a TA (or instructor) who can TUT this course
-                    for (auto& t : tas) {
-                        if ((t.qualRoles.empty() || t.qualRoles.count("TUT")) && (t.qualCourses.empty() || t.qualCourses.count(v.courseId))) {
-                            // attach TA and choose an instructor optionally as supervisor: we'll allow empty instructor
-                            domains[i].push_back({ ts.id, rptr->id, string(), t.id });
-                        }
-                    }
-                    // also allow instructors to handle TUT if qualified
-                    for (auto& ins : instructors) { if (ins.qualCourses.empty() || ins.qualCourses.count(v.courseId)) domains[i].push_back({ ts.id, rptr->id, ins.id, string() }); }
-                }
-                else if (v.type == "LAB") {
-                    // labs need both a TA with LAB role or instructor
-                    for (auto& t : tas) {
-                        if ((t.qualRoles.empty() || t.qualRoles.count("LAB")) && (t.qualCourses.empty() || t.qualCourses.count(v.courseId))) {
-                            domains[i].push_back({ ts.id, rptr->id, string(), t.id });
-                        }
-                    }
-                    for (auto& ins : instructors) { if (ins.qualCourses.empty() || ins.qualCourses.count(v.courseId)) domains[i].push_back({ ts.id, rptr->id, ins.id, string() }); }
-                }
-                else {
-                    // fallback: allow instructor or TA
-                    for (auto& ins : instructors) { if (ins.qualCourses.empty() || ins.qualCourses.count(v.courseId)) domains[i].push_back({ ts.id, rptr->id, ins.id, string() }); }
-                    for (auto& t : tas) { if (t.qualCourses.empty() || t.qualCourses.count(v.courseId)) domains[i].push_back({ ts.id, rptr->id, string(), t.id }); }
-                }
-            }
-        }
-        // shuffle domain to add variety
-        std::shuffle(domains[i].begin(), domains[i].end(), std::mt19937(123 + i));
-    }
-}
-
-// --------------------------
-// Constraint checking & assign/unassign
-// --------------------------
-
-bool canAssignVar(int varIdx, const Assignment& a) {
-    // Hard constraints:
-    // - instructor not busy on this timeslot
-    // - ta not busy
-    // - room not busy
-    // - section (students) not busy
-    // - room capacity/type already ensured in domain generation
-
-    // check room
-    if (roomBusy[a.timeslotId].count(a.roomId)) return false;
-    // check instructor
-    if (!a.instructorId.empty()) {
-        if (instrBusy[a.timeslotId].count(a.instructorId)) return false;
-    }
-    if (!a.taId.empty()) {
-        if (taBusy[a.timeslotId].count(a.taId)) return false;
-    }
-    // section
-    auto& v = variables[varIdx];
-    if (sectionBusy[a.timeslotId].count(v.sectionId)) return false;
-    return true;
-}
-
-void doAssign(int varIdx, const Assignment& a) {
-    currentAssign[varIdx] = a;
-    roomBusy[a.timeslotId].insert(a.roomId);
-    if (!a.instructorId.empty()) instrBusy[a.timeslotId].insert(a.instructorId);
-    if (!a.taId.empty()) taBusy[a.timeslotId].insert(a.taId);
-    sectionBusy[a.timeslotId].insert(variables[varIdx].sectionId);
-}
-
-void undoAssign(int varIdx, const Assignment& a) {
-    currentAssign[varIdx] = nullopt;
-    roomBusy[a.timeslotId].erase(a.roomId);
-    if (!a.instructorId.empty()) instrBusy[a.timeslotId].erase(a.instructorId);
-    if (!a.taId.empty()) taBusy[a.timeslotId].erase(a.taId);
-    sectionBusy[a.timeslotId].erase(variables[varIdx].sectionId);
-}
-
-// simple heuristic: choose var with smallest domain size unassigned
-int selectUnassignedVar() {
-    int best = -1; size_t bestSize = SIZE_MAX;
-    for (size_t i = 0; i < variables.size(); ++i) {
-        if (currentAssign[i].has_value()) continue;
-        // count remaining legal options quickly (no deep forward checking)
-        size_t legal = 0;
-        for (auto& d : domains[i]) if (canAssignVar(i, d)) ++legal;
-        if (legal < bestSize) { bestSize = legal; best = (int)i; }
-    }
-    return best;
-}
-
-bool backtrack(int depth = 0) {
-    // check completion
-    bool allAssigned = true;
-    for (auto& x : currentAssign) if (!x.has_value()) { allAssigned = false; break; }
-    if (allAssigned) return true;
-
-    int var = selectUnassignedVar();
-    if (var == -1) return false; // no viable var
-
-    // try domain items
-    for (auto& d : domains[var]) {
-        if (!canAssignVar(var, d)) continue;
-        doAssign(var, d);
-        if (backtrack(depth + 1)) return true;
-        undoAssign(var, d);
-    }
-    return false;
-}
-
-// --------------------------
-// Loading functions for your CSV formats (expecting simple headers)
-// The loader is flexible: if CSV has headers, we search columns by name.
-// --------------------------
-string getField(const vector<string>& row, const unordered_map<string, int>& map, const string& col) {
-    auto it = map.find(col);
-    if (it == map.end()) return string();
-    int idx = it->second;
-    if (idx < 0 || idx >= (int)row.size()) return string();
-    return row[idx];
-}
-
-unordered_map<string, int> headerIndex(const vector<string>& headerRow) {
-    unordered_map<string, int> m;
-    for (size_t i = 0; i < headerRow.size(); ++i) {
-        string s = headerRow[i];
-        for (auto& c : s) c = tolower(c);
-        m[s] = (int)i;
-    }
-    return m;
-}
-
-void loadAllCSV(const string& dir = ".") {
-    // Courses.csv: id,name
-    auto rows = loadCSV(dir + "/Courses.csv");
-    if (!rows.empty()) {
-        auto hdr = headerIndex(rows[0]);
-        for (size_t i = 1; i < rows.size(); ++i) {
-            Course c; c.id = getField(rows[i], hdr, "id"); c.name = getField(rows[i], hdr, "name");
-            if (c.id.empty()) continue; courses.push_back(c); courseById[c.id] = &courses.back();
-        }
-    }
-    // TimeSlots.csv: id,day,start,end
-    rows = loadCSV(dir + "/TimeSlots.csv");
-    if (!rows.empty()) {
-        auto hdr = headerIndex(rows[0]);
-        for (size_t i = 1; i < rows.size(); ++i) {
-            TimeSlot t; t.id = getField(rows[i], hdr, "id"); t.day = getField(rows[i], hdr, "day"); t.start = getField(rows[i], hdr, "start"); t.end = getField(rows[i], hdr, "end");
-            if (t.id.empty()) continue; timeslots.push_back(t); timeslotById[t.id] = &timeslots.back();
-        }
-    }
-    // Halls.csv: id,type,capacity
-    rows = loadCSV(dir + "/Halls.csv");
-    if (!rows.empty()) {
-        auto hdr = headerIndex(rows[0]);
-        for (size_t i = 1; i < rows.size(); ++i) {
-            Room r; r.id = getField(rows[i], hdr, "id"); r.type = getField(rows[i], hdr, "type"); string cap = getField(rows[i], hdr, "capacity"); r.capacity = cap.empty() ? 0 : stoi(cap);
-            if (r.id.empty()) continue; rooms.push_back(r); roomById[r.id] = &rooms.back();
-        }
-    }
-    // Instructor.csv: id,name,qualified_courses (semicolon separated)
-    rows = loadCSV(dir + "/Instructor.csv");
-    if (!rows.empty()) {
-        auto hdr = headerIndex(rows[0]);
-        for (size_t i = 1; i < rows.size(); ++i) {
-            Instructor ins; ins.id = getField(rows[i], hdr, "id"); ins.name = getField(rows[i], hdr, "name");
-            string q = getField(rows[i], hdr, "qualified_courses");
-            if (!q.empty()) {
-                string tmp; for (char c : q) { if (c == ';') { ins.qualCourses.insert(tmp); tmp.clear(); } else tmp.push_back(c); } if (!tmp.empty()) ins.qualCourses.insert(tmp);
-            }
-            if (ins.id.empty()) continue; instructors.push_back(ins); instrById[ins.id] = &instructors.back();
-        }
-    }
-    // TAs.csv: id,name,roles (semicolon),qualified_courses (semicolon)
-    rows = loadCSV(dir + "/TAs.csv");
-    if (!rows.empty()) {
-        auto hdr = headerIndex(rows[0]);
-        for (size_t i = 1; i < rows.size(); ++i) {
-            TA t; t.id = getField(rows[i], hdr, "id"); t.name = getField(rows[i], hdr, "name");
-            string roles = getField(rows[i], hdr, "roles");
-            if (!roles.empty()) { string tmp; for (char c : roles) { if (c == ';') { t.qualRoles.insert(tmp); tmp.clear(); } else tmp.push_back(c); } if (!tmp.empty()) t.qualRoles.insert(tmp); }
-            string q = getField(rows[i], hdr, "qualified_courses");
-            if (!q.empty()) { string tmp; for (char c : q) { if (c == ';') { t.qualCourses.insert(tmp); tmp.clear(); } else tmp.push_back(c); } if (!tmp.empty()) t.qualCourses.insert(tmp); }
-            if (t.id.empty()) continue; tas.push_back(t); taById[t.id] = &tas.back();
-        }
-    }
-    // Sections.csv: id,courseId,size,sessions (semicolon list like LEC;TUT;LAB)
-    rows = loadCSV(dir + "/Sections.csv");
-    if (!rows.empty()) {
-        auto hdr = headerIndex(rows[0]);
-        for (size_t i = 1; i < rows.size(); ++i) {
-            Section s; s.id = getField(rows[i], hdr, "id"); s.courseId = getField(rows[i], hdr, "courseid");
-            string sz = getField(rows[i], hdr, "size"); s.size = sz.empty() ? 0 : stoi(sz);
-            string sess = getField(rows[i], hdr, "sessions"); if (!sess.empty()) { string tmp; for (char c : sess) { if (c == ';') { s.sessionTypes.push_back(tmp); tmp.clear(); } else tmp.push_back(c); } if (!tmp.empty()) s.sessionTypes.push_back(tmp); }
-            if (s.id.empty()) continue; sections.push_back(s); sectionById[s.id] = &sections.back();
-        }
-    }
-}
-
-void buildVariablesFromSections() {
-    variables.clear();
-    for (auto& sec : sections) {
-        for (auto& st : sec.sessionTypes) {
-            SessionVar v;
-            v.sectionId = sec.id;
-            v.courseId = sec.courseId;
-            v.type = st;
-            v.neededCapacity = sec.size;
-            v.id = sec.id + "::" + st;
-            variables.push_back(v);
-        }
-    }
-}
-
-// --------------------------
-// Output
-// --------------------------
-void printSolution() {
-    cout << "=== Solution ===\n";
-    for (size_t i = 0; i < variables.size(); ++i) {
-        cout << variables[i].id << " => ";
-        if (currentAssign[i].has_value()) {
-            auto a = currentAssign[i].value();
-            cout << "Timeslot=" << a.timeslotId << " Room=" << a.roomId;
-            if (!a.instructorId.empty()) cout << " Instructor=" << a.instructorId;
-            if (!a.taId.empty()) cout << " TA=" << a.taId;
-            cout << "\n";
-        }
-        else cout << "UNASSIGNED\n";
-    }
-}
-
-int main(int argc, char** argv) {
-    string dir = "."; // you can pass a folder path as first arg
-    if (argc > 1) dir = argv[1];
-    cout << "Loading CSVs from: " << dir << "\n";
-    loadAllCSV(dir);
-    buildVariablesFromSections();
-    if (variables.empty()) {
-        cerr << "No variables to schedule. Check Sections.csv and session types.\n";
-        return 1;
-    }
-    buildDomains();
-    currentAssign.resize(variables.size());
-
-    cout << "Variables: " << variables.size() << "\n";
-    size_t totalDomain = 0; for (auto& d : domains) totalDomain += d.size();
-    cout << "Average domain size: "; if (variables.size()) cout << (double)totalDomain / variables.size(); cout << "\n";
-
-    bool ok = backtrack();
-    if (ok) { printSolution(); return 0; }
-    cerr << "Failed to find a complete schedule with the given hard constraints.\n";
-    return 2;
-}
+// timetable_scheduler.cpp
+// Single-file C++17 program to load CSVs and solve a course-timetabling CSP
+// Provided CSV filenames (place them next to the executable):
+// Courses.csv, Instructor.csv, TAs.csv, Halls.csv, TimeSlots.csv, Sections.csv (or .xlsx),
+// optionally RoomRules.csv (SessionType,CoursePattern,RoomTypes,MinCapacity; see room_rules.h)
+// Build: g++ -std=c++17 timetable_scheduler.cpp -O2 -pthread -o scheduler
+//        (add alloc_counter.cpp to count the search loop's heap allocations in the stats)
+// Run: ./scheduler [dir] [--threads N] [--portfolio] [--snapshot FILE] [--progress SECONDS] [--stats FILE|-]
+//      [--export DIR] [--export-format csv,json,ics|all] [--export-week YYYY-MM-DD]
+//      [--engine backtrack|sat] [--sat-conflicts N]
+
+#include <bits/stdc++.h>
+#include "csv_reader.h"
+#include "xlsx_reader.h"
+#include "snapshot_io.h"
+#include "search_stats.h"
+#include "search_arena.h"
+#include "timetable_export.h"
+#include "sat_engine.h"
+#include "room_rules.h"
+using namespace std;
+
+// --------------------------
+// CSV parsing utility
+// --------------------------
+// Rows of string_view cells over the memory-mapped file (see csv_reader.h);
+// when the CSV is missing, the first sheet of the .xlsx with the same name
+unique_ptr<CsvTable> loadCSV(const string& filename) {
+    auto f = make_unique<CsvFile>();
+    if (f->open(filename)) return f;
+    auto book = make_unique<XlsxFile>();
+    if (book->open(filename.substr(0, filename.rfind('.')) + ".xlsx")) return book;
+    cerr << "Failed to open " << filename << "\n";
+    return make_unique<CsvTable>();
+}
+
+// --------------------------
+// Interning: every string key is mapped to a dense integer id at load time
+// --------------------------
+struct Interner {
+    unordered_map<string, int> ids;
+    vector<string> names;
+
+    int intern(const string& s) {
+        auto it = ids.find(s);
+        if (it != ids.end()) return it->second;
+        int id = (int)names.size();
+        ids.emplace(s, id);
+        names.push_back(s);
+        return id;
+    }
+    int find(const string& s) const {
+        auto it = ids.find(s);
+        return it == ids.end() ? -1 : it->second;
+    }
+    int size() const { return (int)names.size(); }
+};
+
+enum SessionType : uint8_t { SESSION_LEC, SESSION_TUT, SESSION_LAB, SESSION_OTHER };
+
+// Role bits for TA qualifications
+enum : uint8_t { ROLE_TUT = 1, ROLE_LAB = 2 };
+
+SessionType parseSessionType(const string& s) {
+    if (s == "LEC") return SESSION_LEC;
+    if (s == "TUT") return SESSION_TUT;
+    if (s == "LAB") return SESSION_LAB;
+    return SESSION_OTHER;
+}
+
+const char* sessionTypeName(SessionType t) {
+    switch (t) {
+    case SESSION_LEC: return "LEC";
+    case SESSION_TUT: return "TUT";
+    case SESSION_LAB: return "LAB";
+    default: return "OTHER";
+    }
+}
+
+// --------------------------
+// Data model
+// --------------------------
+struct Course {
+    string id; // course code
+    string name;
+    // other attributes if present
+};
+
+struct TimeSlot {
+    string id; // unique id
+    string day; // e.g., Mon
+    string start; // e.g., 08:00
+    string end;   // e.g., 09:30
+};
+
+struct Room {
+    string id;
+    string type; // Classroom, ComputerLab, PHY_LAB, etc.
+    int capacity;
+};
+
+struct Instructor {
+    string id;
+    string name;
+    // qualifications: interned course ids (empty = any course)
+    vector<int> qualCourses;
+};
+
+struct TA {
+    string id;
+    string name;
+    uint8_t qualRoles = 0; // ROLE_* bits, 0 = any role
+    vector<int> qualCourses; // interned course ids (empty = any course)
+};
+
+struct Section {
+    string id; // e.g., CS101-1
+    int course; // interned course id
+    int size; // number of students
+    // which session types required: LEC, TUT, LAB
+    vector<SessionType> sessionTypes;
+};
+
+// Variables to assign, one row per session instance (struct of arrays)
+struct VariableTable {
+    vector<int> section;
+    vector<int> course;
+    vector<SessionType> type;
+    vector<int> neededCapacity;
+
+    size_t size() const { return section.size(); }
+    bool empty() const { return section.empty(); }
+    void clear() { section.clear(); course.clear(); type.clear(); neededCapacity.clear(); }
+    void add(int sec, int crs, SessionType t, int cap) {
+        section.push_back(sec); course.push_back(crs); type.push_back(t); neededCapacity.push_back(cap);
+    }
+};
+
+// One candidate value; every field is a dense index, -1 when unused
+struct Assignment {
+    int timeslot = -1;
+    int room = -1;
+    int instructor = -1; // -1 for TAs-only sessions
+    int ta = -1; // optional
+};
+
+// Current assignment of every variable (struct of arrays, timeslot -1 = unassigned)
+struct AssignmentTable {
+    vector<int> timeslot, room, instructor, ta;
+
+    void reset(size_t n) {
+        timeslot.assign(n, -1); room.assign(n, -1); instructor.assign(n, -1); ta.assign(n, -1);
+    }
+    bool assigned(int v) const { return timeslot[v] >= 0; }
+    Assignment get(int v) const { return { timeslot[v], room[v], instructor[v], ta[v] }; }
+    void set(int v, const Assignment& a) {
+        timeslot[v] = a.timeslot; room[v] = a.room; instructor[v] = a.instructor; ta[v] = a.ta;
+    }
+    void clear(int v) { set(v, Assignment()); }
+};
+
+// Dense 2D bit matrix: one row of 64-bit words per timeslot
+struct BitTable {
+    int words = 0;
+    vector<uint64_t> bits;
+
+    void init(int rows, int cols) {
+        words = (cols + 63) / 64;
+        bits.assign((size_t)rows * words, 0);
+    }
+    bool test(int row, int col) const {
+        return (bits[(size_t)row * words + (col >> 6)] >> (col & 63)) & 1;
+    }
+    void set(int row, int col) {
+        bits[(size_t)row * words + (col >> 6)] |= uint64_t(1) << (col & 63);
+    }
+    void reset(int row, int col) {
+        bits[(size_t)row * words + (col >> 6)] &= ~(uint64_t(1) << (col & 63));
+    }
+    const uint64_t* row(int r) const { return bits.data() + (size_t)r * words; }
+};
+
+// True if some bit set in mask is clear in busy
+static bool anyFree(const uint64_t* mask, const uint64_t* busy, int words) {
+    for (int w = 0; w < words; ++w) if (mask[w] & ~busy[w]) return true;
+    return false;
+}
+
+// --------------------------
+// Global data
+// --------------------------
+vector<Course> courses;
+vector<TimeSlot> timeslots;
+vector<Room> rooms;
+vector<Instructor> instructors;
+vector<TA> tas;
+vector<Section> sections;
+VariableTable variables;
+
+// String id -> dense index; course ids also cover codes only seen in qualifications
+Interner courseIds;
+Interner timeslotIds;
+Interner roomIds;
+Interner instrIds;
+Interner taIds;
+Interner sectionIds;
+
+// Domains per variable in factored form: every timeslot, plus candidate rooms
+// and teachers listed once. A value is any (timeslot, room, teacher)
+// combination of the three; combinations are never stored but enumerated on
+// demand by ValueCursor, with the joint constraints checked as they come up.
+// Teachers are keyed by teacherKey(): instructor i, or instructors.size() + TA.
+struct DomainTable {
+    vector<vector<int>> rooms;     // var -> candidate rooms, smallest capacity first
+    vector<vector<int>> teachers;  // var -> candidate teacher keys
+
+    size_t size() const { return rooms.size(); }
+    size_t values(size_t v) const { return timeslots.size() * rooms[v].size() * teachers[v].size(); }
+};
+DomainTable domains;
+
+// Search state below is thread_local so that parallel workers never share it;
+// domains, variable indexes and static degrees are built once and only read.
+
+// Current assignment
+thread_local AssignmentTable currentAssign;
+
+// Search counters (see search_stats.h) and this thread's slot in workerStats
+thread_local SearchStats stats;
+thread_local int workerId = 0;
+ProgressReporter progress;
+
+// Conflict trackers for O(1) checks: timeslot x resource bits, plus the var
+// holding each busy (timeslot, room or teacher), read to explain failures
+thread_local BitTable teacherBusy;  // timeslot x teacher key
+thread_local BitTable roomBusy;
+thread_local BitTable sectionBusy;
+thread_local vector<int> roomOwner, teacherOwner;  // timeslot * count + index -> var
+
+// Forward checking on the time factor: a timeslot stays live for a var while
+// its section is free then and so are some candidate room and some candidate
+// teacher. A trail lets undoAssign restore exactly the timeslots pruned by the
+// matching doAssign.
+thread_local BitTable liveTimes;     // var x timeslot
+thread_local vector<int> liveCount;  // var -> number of live timeslots
+enum : int { CAUSE_ROOMS = -1, CAUSE_TEACHERS = -2 };
+struct Removal {
+    int var, timeslot;
+    int cause;  // assigned var that took the section, or CAUSE_ROOMS / CAUSE_TEACHERS
+    int prev;   // previous removal from the same var, -1 if none
+};
+thread_local vector<Removal> fcTrail;
+thread_local vector<int> lastRemoval;  // var -> newest removal on the trail, -1 if none
+thread_local vector<size_t> fcMarks;   // trail size before each doAssign
+thread_local int wipedVar = -1;        // var emptied by the last failed doAssign
+
+// Inverted index (CSR) from a room, teacher key or section to the vars that
+// can use it, and the candidate sets again as var x resource bits
+struct VarIndex {
+    vector<int> start;
+    vector<int> vars;
+};
+VarIndex roomVars, teacherVars, sectionVars;
+BitTable varRooms, varTeachers;
+
+// Variable ordering: unassigned variables bucketed by live timeslot count
+// (intrusive doubly-linked lists), so MRV selection only looks at the lowest
+// non-empty bucket. Ties go to the higher failure weight (dom/wdeg), then the
+// higher static degree.
+thread_local vector<int> bucketHead;             // live count -> first var, -1 if empty
+thread_local vector<int> bucketNext, bucketPrev; // var -> neighbours in its bucket
+thread_local size_t minBucket = 0;               // lower bound on the lowest non-empty bucket
+vector<int> varDegree;                           // vars sharing a section or candidate teacher
+thread_local vector<int> varWeight;              // wipe-outs caused in this var's domain
+thread_local size_t numAssigned = 0;
+thread_local vector<int> timeOffset;             // var -> first timeslot its values try
+
+// Room-compatibility rules (see room_rules.h): labs in rooms typed *LAB*, *COMPUTER* or *PHY*, everything else
+// in *CLASS* or *LECT* rooms, unless RoomRules.csv in dir replaces them
+RoomRules roomRules;
+
+bool loadRoomRules(const string& dir) {
+    roomRules.rules = { { 1 << SESSION_LAB, "*", { "*LAB*", "*COMPUTER*", "*PHY*" }, 0 }, { (1 << ROOM_RULE_TYPES) - 1, "*", { "*CLASS*", "*LECT*" }, 0 } };
+    auto f = make_unique<CsvFile>(); auto book = make_unique<XlsxFile>();
+    unique_ptr<CsvTable> table;
+    if (f->open(dir + "/RoomRules.csv")) table = move(f); else if (book->open(dir + "/RoomRules.xlsx")) table = move(book);
+    string error;
+    if (table && !roomRules.load(*table, error)) { cerr << "RoomRules " << error << "\n"; return false; }
+    vector<string> types; for (const auto& r : rooms) types.push_back(r.type);
+    if (!roomRules.compile(courseIds.names, types)) { cerr << "RoomRules: more than 64 distinct room classes\n"; return false; }
+    return true;
+}
+
+static bool qualifiedFor(const vector<int>& quals, int course) {
+    return quals.empty() || find(quals.begin(), quals.end(), course) != quals.end();
+}
+
+// --------------------------
+// Domain generation
+// --------------------------
+static int teacherKey(const Assignment& a) {
+    return a.instructor >= 0 ? a.instructor : (int)instructors.size() + a.ta;
+}
+
+static Assignment makeValue(int timeslot, int room, int key) {
+    int ni = (int)instructors.size();
+    return { timeslot, room, key < ni ? key : -1, key < ni ? -1 : key - ni };
+}
+
+void buildDomains() {
+    size_t n = variables.size();
+    int ni = (int)instructors.size();
+    domains = DomainTable();
+    domains.rooms.resize(n);
+    domains.teachers.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        SessionType type = variables.type[i];
+        int course = variables.course[i];
+        // candidate rooms: the room rules allow them and they seat neededCapacity, tightest first
+        vector<int>& candidateRooms = domains.rooms[i];
+        for (size_t r = 0; r < rooms.size(); ++r) { if (roomRules.fits(course, type, (int)r, rooms[r].capacity, variables.neededCapacity[i])) candidateRooms.push_back((int)r); }
+        stable_sort(candidateRooms.begin(), candidateRooms.end(), [](int a, int b) { return rooms[a].capacity < rooms[b].capacity; });
+        // candidate instructors or TAs depending on session type; every timeslot is a candidate
+        vector<int>& teachers = domains.teachers[i];
+        auto addInstructors = [&]() { for (int ins = 0; ins < ni; ++ins) { if (qualifiedFor(instructors[ins].qualCourses, course)) teachers.push_back(ins); } };
+        if (type == SESSION_LEC) {
+            // If instructor qualified for the course or no qualification data -> allow
+            addInstructors();
+        }
+        else if (type == SESSION_TUT || type == SESSION_LAB) {
+            // tutorials need a TA with the TUT role, labs one with the LAB role
+            uint8_t role = (type == SESSION_TUT) ? ROLE_TUT : ROLE_LAB;
+            for (int t = 0; t < (int)tas.size(); ++t) {
+                if ((tas[t].qualRoles == 0 || (tas[t].qualRoles & role)) && qualifiedFor(tas[t].qualCourses, course)) teachers.push_back(ni + t);
+            }
+            // also allow instructors to handle the session if qualified
+            addInstructors();
+        }
+        else {
+            // fallback: allow instructor or TA
+            addInstructors();
+            for (int t = 0; t < (int)tas.size(); ++t) { if (qualifiedFor(tas[t].qualCourses, course)) teachers.push_back(ni + t); }
+        }
+    }
+}
+
+// --------------------------
+// Forward checking support
+// --------------------------
+static void buildVarIndex(VarIndex& idx, BitTable* bits, int keys, const function<const vector<int>&(size_t)>& keysOf) {
+    size_t n = variables.size();
+    idx.start.assign(keys + 1, 0);
+    for (size_t v = 0; v < n; ++v) for (int k : keysOf(v)) ++idx.start[k + 1];
+    for (int k = 0; k < keys; ++k) idx.start[k + 1] += idx.start[k];
+    idx.vars.resize(idx.start[keys]);
+    vector<int> fill(idx.start.begin(), idx.start.end() - 1);
+    if (bits) bits->init((int)n, keys);
+    for (size_t v = 0; v < n; ++v)
+        for (int k : keysOf(v)) { idx.vars[fill[k]++] = (int)v; if (bits) bits->set((int)v, k); }
+}
+
+void initForwardChecking() {
+    int teachers = (int)(instructors.size() + tas.size());
+    vector<vector<int>> sectionOf(variables.size());
+    for (size_t v = 0; v < variables.size(); ++v) sectionOf[v] = { variables.section[v] };
+    buildVarIndex(roomVars, &varRooms, (int)rooms.size(), [](size_t v) -> const vector<int>& { return domains.rooms[v]; });
+    buildVarIndex(teacherVars, &varTeachers, teachers, [](size_t v) -> const vector<int>& { return domains.teachers[v]; });
+    buildVarIndex(sectionVars, nullptr, (int)sections.size(), [&](size_t v) -> const vector<int>& { return sectionOf[v]; });
+}
+
+static void bucketInsert(int v) {
+    int b = liveCount[v];
+    bucketPrev[v] = -1;
+    bucketNext[v] = bucketHead[b];
+    if (bucketHead[b] >= 0) bucketPrev[bucketHead[b]] = v;
+    bucketHead[b] = v;
+    if ((size_t)b < minBucket) minBucket = b;
+}
+
+static void bucketErase(int v) {
+    if (bucketPrev[v] >= 0) bucketNext[bucketPrev[v]] = bucketNext[v];
+    else bucketHead[liveCount[v]] = bucketNext[v];
+    if (bucketNext[v] >= 0) bucketPrev[bucketNext[v]] = bucketPrev[v];
+}
+
+void initOrdering() {
+    size_t n = variables.size();
+
+    // static degree: other variables sharing the section or a candidate teacher
+    vector<int> stamp(n, -1);
+    varDegree.assign(n, 0);
+    auto count = [&](size_t v, const VarIndex& idx, int key) {
+        for (int k = idx.start[key]; k < idx.start[key + 1]; ++k) {
+            int u = idx.vars[k];
+            if (u != (int)v && stamp[u] != (int)v) { stamp[u] = (int)v; ++varDegree[v]; }
+        }
+    };
+    for (size_t v = 0; v < n; ++v) {
+        count(v, sectionVars, variables.section[v]);
+        for (int key : domains.teachers[v]) count(v, teacherVars, key);
+    }
+}
+
+// Removes timeslot t from every other unassigned var of idx[key] that cannot
+// use it any more; false on a wipe-out
+template <class Supported> static bool pruneVars(const VarIndex& idx, int key, int t, int cause, Supported supported) {
+    bool ok = true;
+    for (int k = idx.start[key]; k < idx.start[key + 1]; ++k) {
+        int v = idx.vars[k];
+        if (currentAssign.assigned(v) || !liveTimes.test(v, t) || supported(v)) continue;
+        liveTimes.reset(v, t);
+        ++stats.prunings;
+        fcTrail.push_back({ v, t, cause, lastRemoval[v] });
+        lastRemoval[v] = (int)fcTrail.size() - 1;
+        bucketErase(v);
+        --liveCount[v];
+        bucketInsert(v);
+        if (liveCount[v] == 0) {
+            if (ok) wipedVar = v;
+            ok = false;
+            ++varWeight[v];
+        }
+    }
+    return ok;
+}
+
+// --------------------------
+// Constraint checking & assign/unassign
+// --------------------------
+
+void initBusyTables() {
+    int n = (int)timeslots.size();
+    int teachers = (int)(instructors.size() + tas.size());
+    roomBusy.init(n, (int)rooms.size());
+    teacherBusy.init(n, teachers);
+    sectionBusy.init(n, (int)sections.size());
+    roomOwner.assign((size_t)n * rooms.size(), -1);
+    teacherOwner.assign((size_t)n * teachers, -1);
+}
+
+static void resetLevels(size_t n);
+
+// Fresh search state for the calling thread. Worker 0 starts every var's
+// timeslots at an offset drawn with the old per-var domain seed; worker w > 0
+// shifts that seed by w * variables.size().
+void resetSearch(int worker = 0) {
+    size_t n = variables.size();
+    int nt = (int)timeslots.size();
+    currentAssign.reset(n);
+    initBusyTables();
+    liveTimes.init((int)n, nt);
+    liveCount.assign(n, 0);
+    for (size_t v = 0; v < n; ++v) {
+        if (domains.rooms[v].empty() || domains.teachers[v].empty()) continue;
+        for (int t = 0; t < nt; ++t) liveTimes.set((int)v, t);
+        liveCount[v] = nt;
+    }
+    // the trail holds each (var, timeslot) at most once and fcMarks one mark per var
+    fcTrail.clear();
+    fcTrail.reserve(n * nt);
+    lastRemoval.assign(n, -1);
+    fcMarks.clear();
+    fcMarks.reserve(n);
+    resetLevels(n);
+
+    bucketHead.assign(nt + 1, -1);
+    bucketNext.assign(n, -1);
+    bucketPrev.assign(n, -1);
+    minBucket = 0;
+    numAssigned = 0;
+    varWeight.assign(n, 1);
+    for (size_t v = 0; v < n; ++v) bucketInsert((int)v);
+
+    stats = SearchStats();
+    timeOffset.assign(n, 0);
+    for (size_t v = 0; v < n && nt > 0; ++v) timeOffset[v] = (int)(std::mt19937(123 + v + worker * n)() % nt);
+}
+
+bool canAssignVar(int varIdx, const Assignment& a) {
+    // Hard constraints:
+    // - teacher (instructor or TA) not busy on this timeslot
+    // - room not busy
+    // - section (students) not busy
+    // - room capacity/type already ensured in domain generation
+
+    // check room
+    if (roomBusy.test(a.timeslot, a.room)) return false;
+    // check teacher
+    if (teacherBusy.test(a.timeslot, teacherKey(a))) return false;
+    // section
+    if (sectionBusy.test(a.timeslot, variables.section[varIdx])) return false;
+    return true;
+}
+
+// Assigns and forward-checks; returns false if some future variable lost its
+// last timeslot. The assignment must be undone with undoAssign either way.
+bool doAssign(int varIdx, const Assignment& a) {
+    int t = a.timeslot, key = teacherKey(a);
+    bucketErase(varIdx);
+    ++numAssigned;
+    currentAssign.set(varIdx, a);
+    roomBusy.set(t, a.room);
+    teacherBusy.set(t, key);
+    sectionBusy.set(t, variables.section[varIdx]);
+    roomOwner[(size_t)t * rooms.size() + a.room] = varIdx;
+    teacherOwner[(size_t)t * (instructors.size() + tas.size()) + key] = varIdx;
+
+    fcMarks.push_back(fcTrail.size());
+    ++stats.propagations;
+    bool ok = true;
+    // every resource is pruned even after a wipe-out; the first one is counted as the cause
+    auto prune = [&](const VarIndex& idx, int index, int cause, ConflictKind kind, auto supported) {
+        if (!pruneVars(idx, index, t, cause, supported) && ok) { ok = false; ++stats.failures[kind]; }
+    };
+    prune(roomVars, a.room, CAUSE_ROOMS, CONFLICT_ROOM, [&](int v) { return anyFree(varRooms.row(v), roomBusy.row(t), roomBusy.words); });
+    prune(teacherVars, key, CAUSE_TEACHERS, CONFLICT_TEACHER, [&](int v) { return anyFree(varTeachers.row(v), teacherBusy.row(t), teacherBusy.words); });
+    prune(sectionVars, variables.section[varIdx], varIdx, CONFLICT_SECTION, [](int) { return false; });
+    return ok;
+}
+
+void undoAssign(int varIdx, const Assignment& a) {
+    size_t mark = fcMarks.back();
+    fcMarks.pop_back();
+    while (fcTrail.size() > mark) {
+        auto [v, t, cause, prev] = fcTrail.back();
+        fcTrail.pop_back();
+        lastRemoval[v] = prev;
+        liveTimes.set(v, t);
+        bucketErase(v);
+        ++liveCount[v];
+        bucketInsert(v);
+    }
+    currentAssign.clear(varIdx);
+    --numAssigned;
+    bucketInsert(varIdx);
+    roomBusy.reset(a.timeslot, a.room);
+    teacherBusy.reset(a.timeslot, teacherKey(a));
+    sectionBusy.reset(a.timeslot, variables.section[varIdx]);
+}
+
+// MRV: the unassigned var with the fewest live timeslots, ties by dom/wdeg then degree
+int selectUnassignedVar() {
+    while (minBucket < bucketHead.size() && bucketHead[minBucket] < 0) ++minBucket;
+    if (minBucket == bucketHead.size()) return -1;
+    int best = bucketHead[minBucket];
+    for (int v = bucketNext[best]; v >= 0; v = bucketNext[v]) {
+        if (varWeight[v] > varWeight[best] || (varWeight[v] == varWeight[best] && varDegree[v] > varDegree[best])) best = v;
+    }
+    return best;
+}
+
+// Lazy enumeration of the values of var that fit the current state: live
+// timeslots from the var's offset on, then its free candidate rooms tightest
+// first, then its free candidate teachers. The state may change between calls
+// as long as it is restored before the next one.
+struct ValueCursor {
+    int var;
+    int step = 0, room = 0, teacher = 0;  // positions in timeslots, rooms and teachers
+
+    explicit ValueCursor(int v) : var(v) {}
+    bool next(Assignment& a) {
+        const vector<int>& rs = domains.rooms[var];
+        const vector<int>& ks = domains.teachers[var];
+        int nt = (int)timeslots.size();
+        for (; step < nt; ++step, room = 0, teacher = 0) {
+            int t = (timeOffset[var] + step) % nt;
+            if (!liveTimes.test(var, t)) continue;
+            for (; room < (int)rs.size(); ++room, teacher = 0) {
+                if (roomBusy.test(t, rs[room])) continue;
+                while (teacher < (int)ks.size()) {
+                    int key = ks[teacher++];
+                    if (!teacherBusy.test(t, key)) { a = makeValue(t, rs[room], key); return true; }
+                }
+            }
+        }
+        return false;
+    }
+};
+
+// --------------------------
+// Backjumping & nogood learning
+// --------------------------
+
+thread_local vector<int> conflictItems;  // conflict sets of the levels on the path, innermost last
+thread_local vector<int> conflictMarks;  // var -> stamp of the conflict set holding it
+thread_local int conflictStamp = 0;
+
+// Conflict set of one search level: the tail of conflictItems from start on,
+// which only the innermost level adds to. Vars are deduplicated through a
+// per-var stamp; a deeper level may overwrite stamps, which only leaves
+// duplicates for normalize() to drop.
+struct ConflictSet {
+    size_t start = 0;
+    int stamp = 0;
+
+    void push_back(int v) {
+        if (conflictMarks[v] == stamp) return;
+        conflictMarks[v] = stamp;
+        if (conflictItems.size() == conflictItems.capacity()) normalize(-1); // room before the arena has to grow
+        conflictItems.push_back(v);
+    }
+    // Sorted and unique, without var
+    void normalize(int var) {
+        auto first = conflictItems.begin() + start;
+        conflictItems.erase(remove(first, conflictItems.end(), var), conflictItems.end());
+        sort(first, conflictItems.end());
+        conflictItems.erase(unique(first, conflictItems.end()), conflictItems.end());
+    }
+};
+
+// Assigned vars holding a resource of mask at timeslot t
+static void addOwners(const uint64_t* mask, const BitTable& busy, const vector<int>& owners, int t, ConflictSet& out) {
+    const uint64_t* row = busy.row(t);
+    size_t stride = owners.size() / timeslots.size();
+    for (int w = 0; w < busy.words; ++w)
+        for (uint64_t bits = mask[w] & row[w]; bits; bits &= bits - 1) out.push_back(owners[(size_t)t * stride + w * 64 + __builtin_ctzll(bits)]);
+}
+
+// Assigned vars whose doAssign pruned timeslots of v: the holder of its
+// section, or every holder of its candidate rooms or teachers at that timeslot
+static void explainRemovals(int v, ConflictSet& out) {
+    for (int e = lastRemoval[v]; e >= 0; e = fcTrail[e].prev) {
+        const Removal& r = fcTrail[e];
+        if (r.cause >= 0) out.push_back(r.cause);
+        else if (r.cause == CAUSE_ROOMS) addOwners(varRooms.row(v), roomBusy, roomOwner, r.timeslot, out);
+        else addOwners(varTeachers.row(v), teacherBusy, teacherOwner, r.timeslot, out);
+    }
+}
+
+// Nogoods are (var, timeslot, room, teacher) placements that cannot all hold
+// together, kept in a NogoodStore (search_arena.h)
+static uint64_t placementKey(int var, const Assignment& a) {
+    return ((uint64_t)var << 40) | ((uint64_t)a.timeslot << 28) | ((uint64_t)a.room << 14) | (uint64_t)teacherKey(a);
+}
+
+static bool placementHolds(uint64_t key) {
+    int v = (int)(key >> 40);
+    return currentAssign.assigned(v) && placementKey(v, currentAssign.get(v)) == key;
+}
+
+// One level of backtrack()'s explicit stack
+struct SearchFrame {
+    int var = -1;
+    ValueCursor values{ -1 };
+    Assignment value;   // being tried
+    ConflictSet conf;
+};
+
+thread_local vector<SearchFrame> frames;  // level -> its frame
+thread_local NogoodStore nogoods;
+thread_local vector<int> failure;         // conflict set (vars) of the last failed level
+atomic<bool> stopSearch{ false };         // raised when a worker finishes the whole search
+
+// Sizes the levels for n vars; a level's conflict set holds at most the vars
+// assigned above it, deep paths keep a few hundred each at worst, and
+// untouched pages cost nothing
+static void resetLevels(size_t n) {
+    frames.resize(n);
+    conflictItems.clear();
+    conflictItems.reserve(min(n * (n + 1) / 2, 128 * n) + 4096);
+    conflictMarks.assign(n, 0);
+    failure.clear();
+    failure.reserve(n);
+    nogoods.clear();
+}
+
+// Forward checking search with conflict-directed backjumping: a failed subtree
+// reports the assigned vars that caused it, and a level whose var is not among
+// them returns at once instead of trying its remaining values. Every exhausted
+// level is also stored as a nogood. The levels live in frames rather than on
+// the call stack, and the loop only uses memory resetSearch() set aside; the
+// stats count any heap allocation it makes anyway.
+bool backtrack() {
+    uint64_t allocations = thread_allocations();
+    auto done = [&](bool found) { stats.allocations += thread_allocations() - allocations; return found; };
+    enum { ENTER, NEXT_VALUE, FAILED } step = ENTER; // FAILED: the level failed, failure says why
+    int level = 0;
+    for (;;) {
+        if (step == ENTER) {
+            stats.maxDepth = max(stats.maxDepth, (int)numAssigned);
+            // check completion
+            if (numAssigned == variables.size()) return done(true);
+            if (stopSearch.load(memory_order_relaxed)) { failure.clear(); step = FAILED; continue; } // unwinds every level
+            int var = selectUnassignedVar();
+            if (var == -1) { step = FAILED; continue; } // no viable var
+            SearchFrame& f = frames[level];
+            f.var = var;
+            f.values = ValueCursor(var); // the values of the live timeslots, built one at a time
+            f.conf = { conflictItems.size(), ++conflictStamp };
+            explainRemovals(var, f.conf);
+            step = NEXT_VALUE;
+        }
+        else if (step == FAILED) {
+            if (--level < 0) return done(false);
+            SearchFrame& f = frames[level];
+            if (find(failure.begin(), failure.end(), f.var) == failure.end()) {
+                // var played no part in the failure below: jump over it
+                ++stats.backjumps;
+                undoAssign(f.var, f.value);
+                conflictItems.resize(f.conf.start);
+                continue;
+            }
+            for (int v : failure) f.conf.push_back(v);
+            undoAssign(f.var, f.value);
+            step = NEXT_VALUE;
+        }
+        else {
+            SearchFrame& f = frames[level];
+            int var = f.var;
+            if (!f.values.next(f.value)) {
+                // rooms and teachers the cursor skipped as busy at a live timeslot
+                for (int t = 0; t < (int)timeslots.size(); ++t) {
+                    if (!liveTimes.test(var, t)) continue;
+                    addOwners(varRooms.row(var), roomBusy, roomOwner, t, f.conf);
+                    addOwners(varTeachers.row(var), teacherBusy, teacherOwner, t, f.conf);
+                }
+                f.conf.normalize(var);
+                const int* conf = conflictItems.data() + f.conf.start;
+                stats.nogoodsLearned += nogoods.add(conflictItems.size() - f.conf.start, [&](size_t i) { return placementKey(conf[i], currentAssign.get(conf[i])); });
+                ++stats.backtracks;
+                failure.assign(conflictItems.begin() + f.conf.start, conflictItems.end());
+                conflictItems.resize(f.conf.start);
+                step = FAILED;
+                continue;
+            }
+            if ((++stats.nodes & ProgressReporter::PUBLISH_MASK) == 0 && progress.enabled()) progress.publish(workerId, stats, (int)numAssigned);
+            bool ok = doAssign(var, f.value);
+            if (!ok) explainRemovals(wipedVar, f.conf);
+            else {
+                int nogood = nogoods.violated(placementKey(var, f.value), placementHolds);
+                if (nogood >= 0) {
+                    ok = false;
+                    ++stats.failures[CONFLICT_NOGOOD];
+                    for (uint64_t key : nogoods.nogood(nogood)) f.conf.push_back((int)(key >> 40));
+                }
+            }
+            if (ok) { ++level; step = ENTER; }
+            else undoAssign(var, f.value);
+        }
+    }
+}
+
+// --------------------------
+// Parallel search: split mode hands the values of the first MRV variable out as
+// tasks on a work-stealing pool; portfolio mode runs the full search once per
+// worker with differently seeded value orders. The first complete schedule
+// raises stopSearch and is copied into solution.
+// --------------------------
+struct TaskQueue {
+    mutex lock;
+    deque<Assignment> values; // values of the split variable
+};
+vector<TaskQueue> taskQueues;
+AssignmentTable solution;
+bool solutionFound = false;
+
+// Own queue from the front, otherwise steal from the back of another queue
+static bool nextTask(int worker, Assignment& value) {
+    for (size_t k = 0; k < taskQueues.size(); ++k) {
+        TaskQueue& q = taskQueues[(worker + k) % taskQueues.size()];
+        lock_guard<mutex> guard(q.lock);
+        if (q.values.empty()) continue;
+        if (k == 0) { value = q.values.front(); q.values.pop_front(); }
+        else { value = q.values.back(); q.values.pop_back(); }
+        return true;
+    }
+    return false;
+}
+
+vector<SearchStats> workerStats; // worker -> its counters once it finished
+
+static void searchWorker(int worker, int splitVar, bool portfolio) {
+    workerId = worker;
+    resetSearch(portfolio ? worker : 0);
+    bool found = false;
+    if (portfolio) found = backtrack();
+    else {
+        Assignment d;
+        while (!found && !stopSearch.load() && nextTask(worker, d)) {
+            if (doAssign(splitVar, d)) {
+                found = backtrack();
+                // a conflict set without the split variable holds for all of its values
+                if (!found && !stopSearch.load() && find(failure.begin(), failure.end(), splitVar) == failure.end()) stopSearch = true;
+            }
+            if (!found) undoAssign(splitVar, d);
+        }
+    }
+    if (found && !stopSearch.exchange(true)) { solution = currentAssign; solutionFound = true; }
+    workerStats[worker] = stats;
+}
+
+// Runs the workers; on success the schedule is copied into this thread's currentAssign
+bool solveParallel(int threads, bool portfolio) {
+    int splitVar = selectUnassignedVar();
+    if (!portfolio) {
+        taskQueues = vector<TaskQueue>(threads);
+        ValueCursor values(splitVar);
+        size_t i = 0;
+        for (Assignment d; values.next(d); ++i) taskQueues[i % threads].values.push_back(d);
+    }
+    workerStats.assign(threads, {});
+    vector<thread> workers;
+    for (int w = 0; w < threads; ++w) workers.emplace_back(searchWorker, w, splitVar, portfolio);
+    for (auto& t : workers) t.join();
+    if (!solutionFound) return false;
+    currentAssign = solution;
+    return true;
+}
+
+// --------------------------
+// SAT engine (--engine sat): the factored domains are handed to sat_engine.h
+// and the model is decoded into currentAssign. In the stats, decisions count
+// as nodes, conflicts as backtracks and learnt clauses as nogoods.
+// --------------------------
+static void publishSatStats(const SatStats& sat) {
+    stats.nodes = sat.decisions; stats.backtracks = sat.conflicts; stats.propagations = sat.propagations;
+    stats.nogoodsLearned = sat.learnt; stats.maxDepth = sat.maxLevel;
+    progress.publish(workerId, stats, sat.maxLevel);
+}
+
+bool solveSat(uint64_t conflictLimit) {
+    SatTimetable t;
+    t.times = (int)timeslots.size(); t.rooms = (int)rooms.size(); t.sections = (int)sections.size();
+    t.teachers = (int)(instructors.size() + tas.size());
+    t.sectionStart.push_back(0); t.roomStart.push_back(0); t.teacherStart.push_back(0);
+    for (size_t v = 0; v < variables.size(); ++v) {
+        t.sectionPool.push_back(variables.section[v]); t.sectionStart.push_back((int)t.sectionPool.size());
+        t.roomPool.insert(t.roomPool.end(), domains.rooms[v].begin(), domains.rooms[v].end());
+        t.teacherPool.insert(t.teacherPool.end(), domains.teachers[v].begin(), domains.teachers[v].end());
+        t.roomStart.push_back((int)t.roomPool.size()); t.teacherStart.push_back((int)t.teacherPool.size());
+    }
+    vector<SatPlacement> placement;
+    SatStats sat;
+    SatResult result = solve_timetable_sat(t, placement, sat, conflictLimit, [](const SatStats& now) { publishSatStats(now); return false; });
+    publishSatStats(sat);
+    cerr << "SAT engine: " << sat.vars << " variables, " << sat.clauses << " clauses, "
+        << (result == SAT_SATISFIABLE ? "satisfiable" : result == SAT_UNSATISFIABLE ? "unsatisfiable" : "unknown")
+        << " after " << sat.conflicts << " conflicts, " << sat.decisions << " decisions, " << sat.restarts << " restarts\n";
+    if (result != SAT_SATISFIABLE) return false;
+    for (size_t v = 0; v < variables.size(); ++v) currentAssign.set(v, makeValue(placement[v][0], placement[v][1], placement[v][2]));
+    return true;
+}
+
+// --------------------------
+// Loading functions for your CSV formats (expecting simple headers)
+// The loader is flexible: if CSV has headers, we search columns by name.
+// --------------------------
+string getField(CsvRow row, const unordered_map<string, int>& map, const string& col) {
+    auto it = map.find(col);
+    if (it == map.end()) return string();
+    return string(row[it->second]);
+}
+
+unordered_map<string, int> headerIndex(CsvRow headerRow) {
+    unordered_map<string, int> m;
+    for (size_t i = 0; i < headerRow.size(); ++i) {
+        string s(headerRow[i]);
+        for (auto& c : s) c = tolower(c);
+        m[s] = (int)i;
+    }
+    return m;
+}
+
+void loadAllCSV(const string& dir = ".") {
+    // a repeated id keeps its first row; later rows are reported and skipped
+    auto repeated = [](const Interner& ids, const string& id, const char* table, size_t i) { if (ids.find(id) < 0) return false; cerr << table << " row " << i + 1 << ": " << id << " repeats an earlier id and is skipped\n"; return true; };
+    // Courses.csv: id,name
+    auto rows = loadCSV(dir + "/Courses.csv");
+    if (!rows->empty()) {
+        auto hdr = headerIndex((*rows)[0]);
+        for (size_t i = 1; i < rows->rows(); ++i) {
+            Course c; c.id = getField((*rows)[i], hdr, "id"); c.name = getField((*rows)[i], hdr, "name");
+            if (c.id.empty()) continue; courses.push_back(c); courseIds.intern(c.id);
+        }
+    }
+    // TimeSlots.csv: id,day,start,end
+    rows = loadCSV(dir + "/TimeSlots.csv");
+    if (!rows->empty()) {
+        auto hdr = headerIndex((*rows)[0]);
+        for (size_t i = 1; i < rows->rows(); ++i) {
+            TimeSlot t; t.id = getField((*rows)[i], hdr, "id"); t.day = getField((*rows)[i], hdr, "day"); t.start = getField((*rows)[i], hdr, "start"); t.end = getField((*rows)[i], hdr, "end");
+            if (t.id.empty() || repeated(timeslotIds, t.id, "TimeSlots.csv", i)) continue; timeslotIds.intern(t.id); timeslots.push_back(t);
+        }
+    }
+    // Halls.csv: id,type,capacity
+    rows = loadCSV(dir + "/Halls.csv");
+    if (!rows->empty()) {
+        auto hdr = headerIndex((*rows)[0]);
+        for (size_t i = 1; i < rows->rows(); ++i) {
+            Room r; r.id = getField((*rows)[i], hdr, "id"); r.type = getField((*rows)[i], hdr, "type"); string cap = getField((*rows)[i], hdr, "capacity"); r.capacity = cap.empty() ? 0 : stoi(cap);
+            if (r.id.empty() || repeated(roomIds, r.id, "Halls.csv", i)) continue; roomIds.intern(r.id); rooms.push_back(r);
+        }
+    }
+    // Instructor.csv: id,name,qualified_courses (semicolon separated)
+    rows = loadCSV(dir + "/Instructor.csv");
+    if (!rows->empty()) {
+        auto hdr = headerIndex((*rows)[0]);
+        for (size_t i = 1; i < rows->rows(); ++i) {
+            Instructor ins; ins.id = getField((*rows)[i], hdr, "id"); ins.name = getField((*rows)[i], hdr, "name");
+            string q = getField((*rows)[i], hdr, "qualified_courses");
+            if (!q.empty()) {
+                string tmp; for (char c : q) { if (c == ';') { ins.qualCourses.push_back(courseIds.intern(tmp)); tmp.clear(); } else tmp.push_back(c); } if (!tmp.empty()) ins.qualCourses.push_back(courseIds.intern(tmp));
+            }
+            if (ins.id.empty() || repeated(instrIds, ins.id, "Instructor.csv", i)) continue; instrIds.intern(ins.id); instructors.push_back(ins);
+        }
+    }
+    // TAs.csv: id,name,roles (semicolon),qualified_courses (semicolon)
+    rows = loadCSV(dir + "/TAs.csv");
+    if (!rows->empty()) {
+        auto hdr = headerIndex((*rows)[0]);
+        for (size_t i = 1; i < rows->rows(); ++i) {
+            TA t; t.id = getField((*rows)[i], hdr, "id"); t.name = getField((*rows)[i], hdr, "name");
+            string roles = getField((*rows)[i], hdr, "roles");
+            auto addRole = [&](const string& role) { SessionType st = parseSessionType(role); if (st == SESSION_TUT) t.qualRoles |= ROLE_TUT; else if (st == SESSION_LAB) t.qualRoles |= ROLE_LAB; };
+            if (!roles.empty()) { string tmp; for (char c : roles) { if (c == ';') { addRole(tmp); tmp.clear(); } else tmp.push_back(c); } if (!tmp.empty()) addRole(tmp); }
+            string q = getField((*rows)[i], hdr, "qualified_courses");
+            if (!q.empty()) { string tmp; for (char c : q) { if (c == ';') { t.qualCourses.push_back(courseIds.intern(tmp)); tmp.clear(); } else tmp.push_back(c); } if (!tmp.empty()) t.qualCourses.push_back(courseIds.intern(tmp)); }
+            if (t.id.empty() || repeated(taIds, t.id, "TAs.csv", i)) continue; taIds.intern(t.id); tas.push_back(t);
+        }
+    }
+    // Sections.csv: id,courseId,size,sessions (semicolon list like LEC;TUT;LAB)
+    rows = loadCSV(dir + "/Sections.csv");
+    if (!rows->empty()) {
+        auto hdr = headerIndex((*rows)[0]);
+        for (size_t i = 1; i < rows->rows(); ++i) {
+            Section s; s.id = getField((*rows)[i], hdr, "id"); s.course = courseIds.intern(getField((*rows)[i], hdr, "courseid"));
+            string sz = getField((*rows)[i], hdr, "size"); s.size = sz.empty() ? 0 : stoi(sz);
+            string sess = getField((*rows)[i], hdr, "sessions"); if (!sess.empty()) { string tmp; for (char c : sess) { if (c == ';') { s.sessionTypes.push_back(parseSessionType(tmp)); tmp.clear(); } else tmp.push_back(c); } if (!tmp.empty()) s.sessionTypes.push_back(parseSessionType(tmp)); }
+            if (s.id.empty() || repeated(sectionIds, s.id, "Sections.csv", i)) continue; sectionIds.intern(s.id); sections.push_back(s);
+        }
+    }
+}
+
+void buildVariablesFromSections() {
+    variables.clear();
+    for (size_t si = 0; si < sections.size(); ++si) {
+        auto& sec = sections[si];
+        for (SessionType st : sec.sessionTypes) {
+            variables.add((int)si, sec.course, st, sec.size);
+        }
+    }
+}
+
+// --------------------------
+// Compiled-problem snapshot (see snapshot_io.h): entities, interned ids,
+// variables and candidate domains, reused by --snapshot FILE while the source
+// tables in dir hash the same. Bump SNAPSHOT_VERSION when this layout changes.
+// --------------------------
+const char SNAPSHOT_TAG[4] = { 'D', 'L', 0, 0 };
+const uint32_t SNAPSHOT_VERSION = 2;
+
+uint64_t sourceHash(const string& dir) {
+    vector<string> paths;
+    for (const char* name : { "Courses", "TimeSlots", "Halls", "Instructor", "TAs", "Sections", "RoomRules" }) {
+        paths.push_back(dir + "/" + name + ".csv");
+        paths.push_back(dir + "/" + name + ".xlsx");
+    }
+    return hash_files(paths);
+}
+
+template <class T, class F> vector<F> column(const vector<T>& rows, F T::*field) {
+    vector<F> out; out.reserve(rows.size());
+    for (const auto& row : rows) out.push_back(row.*field);
+    return out;
+}
+
+template <class T, class F> void fillColumn(vector<T>& rows, F T::*field, vector<F>&& values) {
+    rows.resize(values.size());
+    for (size_t i = 0; i < values.size(); ++i) rows[i].*field = move(values[i]);
+}
+
+// Lists flattened to offsets (size rows + 1) plus one value array
+template <class T> void writeLists(SnapshotWriter& out, const vector<vector<T>>& lists) {
+    vector<uint64_t> start{ 0 }; vector<T> flat;
+    for (const auto& l : lists) { flat.insert(flat.end(), l.begin(), l.end()); start.push_back(flat.size()); }
+    out.array(start); out.array(flat);
+}
+
+template <class T> bool readLists(SnapshotReader& in, vector<vector<T>>& lists) {
+    vector<uint64_t> start; vector<T> flat;
+    in.array(start); in.array(flat);
+    if (!in.good() || start.empty() || start.back() != flat.size()) return false;
+    lists.assign(start.size() - 1, {});
+    for (size_t i = 0; i + 1 < start.size(); ++i) {
+        if (start[i] > start[i + 1]) return false;
+        lists[i].assign(flat.begin() + start[i], flat.begin() + start[i + 1]);
+    }
+    return true;
+}
+
+bool saveSnapshot(const string& path, uint64_t hash) {
+    SnapshotWriter out;
+    out.strings(column(courses, &Course::id)); out.strings(column(courses, &Course::name));
+    out.strings(column(timeslots, &TimeSlot::id)); out.strings(column(timeslots, &TimeSlot::day));
+    out.strings(column(timeslots, &TimeSlot::start)); out.strings(column(timeslots, &TimeSlot::end));
+    out.strings(column(rooms, &Room::id)); out.strings(column(rooms, &Room::type)); out.array(column(rooms, &Room::capacity));
+    out.strings(column(instructors, &Instructor::id)); out.strings(column(instructors, &Instructor::name));
+    writeLists(out, column(instructors, &Instructor::qualCourses));
+    out.strings(column(tas, &TA::id)); out.strings(column(tas, &TA::name)); out.array(column(tas, &TA::qualRoles));
+    writeLists(out, column(tas, &TA::qualCourses));
+    out.strings(column(sections, &Section::id)); out.array(column(sections, &Section::course)); out.array(column(sections, &Section::size));
+    writeLists(out, column(sections, &Section::sessionTypes));
+    for (const Interner* it : { &courseIds, &timeslotIds, &roomIds, &instrIds, &taIds, &sectionIds }) out.strings(it->names);
+    out.array(variables.section); out.array(variables.course); out.array(variables.type); out.array(variables.neededCapacity);
+    writeLists(out, domains.rooms); writeLists(out, domains.teachers);
+    return out.save(path, SNAPSHOT_TAG, SNAPSHOT_VERSION, hash);
+}
+
+static bool readSnapshot(SnapshotReader& in) {
+    vector<string> strs; vector<int> ints;
+    auto readStrings = [&]() { in.strings(strs); return move(strs); };
+    auto readInts = [&]() { in.array(ints); return move(ints); };
+    vector<vector<int>> lists;
+    fillColumn(courses, &Course::id, readStrings()); fillColumn(courses, &Course::name, readStrings());
+    fillColumn(timeslots, &TimeSlot::id, readStrings()); fillColumn(timeslots, &TimeSlot::day, readStrings());
+    fillColumn(timeslots, &TimeSlot::start, readStrings()); fillColumn(timeslots, &TimeSlot::end, readStrings());
+    fillColumn(rooms, &Room::id, readStrings()); fillColumn(rooms, &Room::type, readStrings()); fillColumn(rooms, &Room::capacity, readInts());
+    fillColumn(instructors, &Instructor::id, readStrings()); fillColumn(instructors, &Instructor::name, readStrings());
+    if (!readLists(in, lists)) return false;
+    fillColumn(instructors, &Instructor::qualCourses, move(lists));
+    fillColumn(tas, &TA::id, readStrings()); fillColumn(tas, &TA::name, readStrings());
+    vector<uint8_t> roles; in.array(roles); fillColumn(tas, &TA::qualRoles, move(roles));
+    if (!readLists(in, lists)) return false;
+    fillColumn(tas, &TA::qualCourses, move(lists));
+    fillColumn(sections, &Section::id, readStrings()); fillColumn(sections, &Section::course, readInts()); fillColumn(sections, &Section::size, readInts());
+    vector<vector<SessionType>> types;
+    if (!readLists(in, types)) return false;
+    fillColumn(sections, &Section::sessionTypes, move(types));
+    for (Interner* it : { &courseIds, &timeslotIds, &roomIds, &instrIds, &taIds, &sectionIds }) {
+        in.strings(it->names);
+        it->ids.clear();
+        for (int i = 0; i < it->size(); ++i) it->ids.emplace(it->names[i], i);
+    }
+    in.array(variables.section); in.array(variables.course); in.array(variables.type); in.array(variables.neededCapacity);
+    return readLists(in, domains.rooms) && readLists(in, domains.teachers) &&
+        domains.rooms.size() == variables.size() && domains.teachers.size() == variables.size();
+}
+
+// Loads a snapshot written by saveSnapshot for the same sources; false (and
+// nothing loaded) when it is missing, stale or damaged
+bool loadSnapshot(const string& path, uint64_t hash) {
+    SnapshotReader in;
+    if (!in.open(path, SNAPSHOT_TAG, SNAPSHOT_VERSION, hash)) return false;
+    if (readSnapshot(in)) return true;
+    courses.clear(); timeslots.clear(); rooms.clear(); instructors.clear(); tas.clear(); sections.clear();
+    for (Interner* it : { &courseIds, &timeslotIds, &roomIds, &instrIds, &taIds, &sectionIds }) *it = Interner();
+    variables.clear(); domains = DomainTable();
+    return false;
+}
+
+// --------------------------
+// Output
+// --------------------------
+void printSolution() {
+    cout << "=== Solution ===\n";
+    for (size_t i = 0; i < variables.size(); ++i) {
+        cout << sections[variables.section[i]].id << "::" << sessionTypeName(variables.type[i]) << " => ";
+        if (currentAssign.assigned(i)) {
+            Assignment a = currentAssign.get(i);
+            cout << "Timeslot=" << timeslots[a.timeslot].id << " Room=" << rooms[a.room].id;
+            if (a.instructor >= 0) cout << " Instructor=" << instructors[a.instructor].id;
+            if (a.ta >= 0) cout << " TA=" << tas[a.ta].id;
+            cout << "\n";
+        }
+        else cout << "UNASSIGNED\n";
+    }
+}
+
+// Section, teacher and room views of the solution under dir (--export)
+bool exportSolution(const string& dir, const ExportOptions& options) {
+    TimetableExport t;
+    for (auto& ts : timeslots) t.slots.push_back({ ts.id, ts.day, ts.start, ts.end });
+    for (auto& s : sections) t.sections.push_back(s.id);
+    t.courses = courseIds.names;
+    for (auto& r : rooms) t.rooms.push_back(r.id);
+    for (auto& ins : instructors) { t.teachers.push_back(ins.name.empty() ? ins.id : ins.name); t.teacherRoles.push_back("Instructor"); }
+    for (auto& ta : tas) { t.teachers.push_back(ta.name.empty() ? ta.id : ta.name); t.teacherRoles.push_back("TA"); }
+    t.sessions.reserve(variables.size());
+    for (size_t i = 0; i < variables.size(); ++i) {
+        if (!currentAssign.assigned(i)) continue;
+        Assignment a = currentAssign.get(i);
+        t.sessions.push_back({ a.timeslot, variables.section[i], variables.course[i], a.room, teacherKey(a), sessionTypeName(variables.type[i]) });
+    }
+    size_t skipped = 0;
+    bool ok = write_exports(t, dir, options, skipped);
+    if (skipped) cerr << "Export: " << skipped << " calendar events left out for unreadable days or times\n";
+    return ok;
+}
+
+// JSON summary of a run for --stats; path "-" writes to stderr
+bool writeStats(const string& path, const SearchStats& total, const PhaseTimer& timer, int threads, bool solved) {
+    size_t totalDomain = 0; for (size_t v = 0; v < domains.size(); ++v) totalDomain += domains.values(v);
+    ofstream file;
+    if (path != "-") file.open(path);
+    ostream& out = path == "-" ? cerr : file;
+    out << "{\n  \"variables\": " << variables.size() << ",\n  \"domain_items\": " << totalDomain
+        << ",\n  \"threads\": " << threads << ",\n  \"solved\": " << (solved ? "true" : "false") << ",\n  \"phases_ms\": ";
+    timer.write_json(out);
+    out << ",\n  \"search\": ";
+    total.write_json(out);
+    out << "\n}\n";
+    return (bool)out;
+}
+
+int main(int argc, char** argv) {
+    string dir = "."; // you can pass a folder path as first arg
+    int threads = 1;
+    bool portfolio = false;
+    string snapshotPath, statsPath;
+    double progressSeconds = 0;
+    bool useSat = false;
+    uint64_t satConflicts = UINT64_MAX;
+    string exportDir;
+    ExportOptions exportOptions;
+    exportOptions.weekStart = time(nullptr) / 86400;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) threads = max(1, atoi(argv[++i]));
+        else if (arg == "--portfolio") portfolio = true;
+        else if (arg == "--snapshot" && i + 1 < argc) snapshotPath = argv[++i];
+        else if (arg == "--progress" && i + 1 < argc) progressSeconds = atof(argv[++i]);
+        else if (arg == "--stats" && i + 1 < argc) statsPath = argv[++i];
+        else if (arg == "--engine" && i + 1 < argc && (string(argv[i + 1]) == "sat" || string(argv[i + 1]) == "backtrack")) useSat = string(argv[++i]) == "sat";
+        else if (arg == "--sat-conflicts" && i + 1 < argc) satConflicts = strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--export" && i + 1 < argc) exportDir = argv[++i];
+        else if (arg == "--export-format" && i + 1 < argc && parse_export_formats(argv[i + 1], exportOptions)) ++i;
+        else if (arg == "--export-week" && i + 1 < argc && parse_export_date(argv[i + 1], exportOptions.weekStart)) ++i;
+        else if (arg == "--export-format" || arg == "--export-week") { cerr << "Invalid " << arg << (i + 1 < argc ? " " + string(argv[i + 1]) : string(": missing value")) << "\n"; return 1; }
+        else dir = arg;
+    }
+    if (useSat && threads > 1) { cerr << "--threads and --portfolio are ignored with --engine sat\n"; threads = 1; }
+    PhaseTimer timer;
+    uint64_t hash = snapshotPath.empty() ? 0 : sourceHash(dir);
+    if (snapshotPath.empty() || !loadSnapshot(snapshotPath, hash)) {
+        cout << "Loading CSVs from: " << dir << "\n";
+        loadAllCSV(dir);
+        buildVariablesFromSections();
+        if (variables.empty()) {
+            cerr << "No variables to schedule. Check Sections.csv and session types.\n";
+            return 1;
+        }
+        if (!loadRoomRules(dir)) return 1;
+        timer.lap("load");
+        buildDomains();
+        if (!snapshotPath.empty() && !saveSnapshot(snapshotPath, hash)) cerr << "Could not write snapshot " << snapshotPath << "\n";
+    }
+    else {
+        cout << "Loaded snapshot: " << snapshotPath << "\n";
+        timer.lap("load");
+    }
+    initForwardChecking();
+    initOrdering();
+    resetSearch();
+    timer.lap("compile");
+
+    cout << "Variables: " << variables.size() << "\n";
+    size_t totalDomain = 0; for (size_t v = 0; v < domains.size(); ++v) totalDomain += domains.values(v);
+    cout << "Average domain size: "; if (variables.size()) cout << (double)totalDomain / variables.size(); cout << "\n";
+
+    progress.start(progressSeconds, threads, (int)variables.size());
+    bool ok = find(liveCount.begin(), liveCount.end(), 0) == liveCount.end() &&
+        (useSat ? solveSat(satConflicts) : threads > 1 ? solveParallel(threads, portfolio) : backtrack());
+    progress.stop();
+    timer.lap("search");
+    if (ok) printSolution();
+    else cerr << "Failed to find a complete schedule with the given hard constraints.\n";
+    timer.lap("output");
+    if (ok && !exportDir.empty()) {
+        cout.flush();
+        if (!exportSolution(exportDir, exportOptions)) cerr << "Could not write export to " << exportDir << "\n";
+        timer.lap("export");
+    }
+
+    if (!statsPath.empty()) {
+        SearchStats total = stats;
+        for (auto& w : workerStats) total.add(w);
+        if (!writeStats(statsPath, total, timer, threads, ok)) cerr << "Could not write stats " << statsPath << "\n";
+    }
+    return ok ? 0 : 2;
+}
@@ -0,0 +1,184 @@
+// room_rules.h
+// Room-compatibility policy shared by both schedulers, kept as data. A
+// RoomRule names the session types and course codes it covers, the room types
+// those sessions may use and the smallest room they accept. Course patterns
+// and room types are case-insensitive globs ('*' matches any run), and the
+// first rule covering a (course, session type) decides. A program starts from
+// its built-in rules; a RoomRules table (SessionType, CoursePattern,
+// RoomTypes, MinCapacity, lists separated by ';') replaces them.
+//
+// compile() turns the rules into integers once the rooms and courses are
+// loaded. Room types that every rule treats alike share a room class, one bit
+// of a 64-bit mask, and every (course, session type) gets the mask of the
+// classes it may use and its minimum capacity, so checking a room is one AND
+// and one compare.
+#pragma once
+
+#include <bits/stdc++.h>
+#include "csv_reader.h"
+
+// Session types as both programs number them: lecture, tutorial, lab, other.
+const int ROOM_RULE_TYPES = 4;
+
+struct RoomRule {
+    uint8_t sessionTypes = 0;            // bit 1 << type for every covered type
+    std::string coursePattern = "*";
+    std::vector<std::string> roomTypes;  // a room fits when any pattern matches
+    int minCapacity = 0;
+};
+
+// ConsoleApplication1's built-in rules, which the verifier also starts from:
+// lectures and tutorials in classrooms, halls and theaters; physics labs in
+// the physics lab, drawing labs in the drawing studios and other labs in
+// computer labs.
+inline std::vector<RoomRule> timetable_room_rules() {
+    const uint8_t lecture = 1 << 0, tutorial = 1 << 1, lab = 1 << 2;
+    return {
+        { lecture | tutorial, "*", { "Classroom", "Hall", "Theater" }, 0 },
+        { lab, "*PHY*", { "PHY_LAB" }, 0 },
+        { lab, "*Drawing*", { "Drawing Studio", "FoE Drawing Lab" }, 0 },
+        { lab, "*", { "Computer Lab", "Lab" }, 0 },
+    };
+}
+
+// What one (course, session type) may use.
+struct RoomClass {
+    uint64_t rooms = 0;                  // room-class bits
+    int minCapacity = 0;
+};
+
+// Case-insensitive match of text against a pattern whose only wildcard is '*'.
+inline bool room_rule_match(std::string_view pattern, std::string_view text) {
+    size_t p = 0, t = 0, star = std::string_view::npos, resume = 0;
+    while (t < text.size()) {
+        if (p < pattern.size() && pattern[p] == '*') {
+            star = p++;
+            resume = t;
+        }
+        else if (p < pattern.size() && toupper((unsigned char)pattern[p]) == toupper((unsigned char)text[t])) {
+            ++p;
+            ++t;
+        }
+        else if (star != std::string_view::npos) {
+            p = star + 1;
+            t = ++resume;
+        }
+        else return false;
+    }
+    while (p < pattern.size() && pattern[p] == '*') ++p;
+    return p == pattern.size();
+}
+
+class RoomRules {
+public:
+    std::vector<RoomRule> rules;
+
+    // Replaces the rules with the table's rows (the first row is a header).
+    // On a malformed row the rules are left alone and error says why.
+    bool load(const CsvTable& table, std::string& error) {
+        std::vector<RoomRule> parsed;
+        for (size_t i = 1; i < table.rows(); ++i) {
+            CsvRow row = table[i];
+            if (row.size() == 0 || (row.size() == 1 && row[0].empty())) continue;
+            RoomRule rule;
+            std::string where = "row " + std::to_string(i + 1) + ": ";
+            for (const auto& name : split(row[0])) {
+                int type = parse_type(name);
+                if (type < 0) {
+                    error = where + "unknown session type " + name;
+                    return false;
+                }
+                rule.sessionTypes |= type == ROOM_RULE_TYPES ? (1 << ROOM_RULE_TYPES) - 1 : 1 << type;
+            }
+            if (!row[1].empty()) rule.coursePattern = std::string(row[1]);
+            rule.roomTypes = split(row[2]);
+            if (!rule.sessionTypes || rule.roomTypes.empty()) {
+                error = where + "needs session types and room types";
+                return false;
+            }
+            std::string_view cap = row[3];
+            auto [end, ec] = std::from_chars(cap.data(), cap.data() + cap.size(), rule.minCapacity);
+            if (!cap.empty() && (ec != std::errc() || end != cap.data() + cap.size() || rule.minCapacity < 0)) {
+                error = where + "bad minimum capacity " + std::string(cap);
+                return false;
+            }
+            parsed.push_back(std::move(rule));
+        }
+        rules = std::move(parsed);
+        return true;
+    }
+
+    // Compiles the rules for these course codes (by course id) and these room
+    // types (one per room). False when the rooms need more than 64 classes.
+    bool compile(const std::vector<std::string>& courses, const std::vector<std::string>& roomTypes) {
+        // a room type's signature is the set of rules accepting it
+        std::map<std::vector<bool>, uint64_t> classBits;
+        std::vector<uint64_t> ruleRooms(rules.size(), 0);
+        roomBits.assign(roomTypes.size(), 0);
+        for (size_t r = 0; r < roomTypes.size(); ++r) {
+            std::vector<bool> signature(rules.size());
+            for (size_t k = 0; k < rules.size(); ++k) {
+                for (const auto& pattern : rules[k].roomTypes) signature[k] = signature[k] || room_rule_match(pattern, roomTypes[r]);
+            }
+            if (std::find(signature.begin(), signature.end(), true) == signature.end()) continue;
+            auto it = classBits.find(signature);
+            if (it == classBits.end()) {
+                if (classBits.size() == 64) return false;
+                it = classBits.emplace(signature, uint64_t(1) << classBits.size()).first;
+                for (size_t k = 0; k < rules.size(); ++k) {
+                    if (signature[k]) ruleRooms[k] |= it->second;
+                }
+            }
+            roomBits[r] = it->second;
+        }
+        classes.assign(courses.size() * ROOM_RULE_TYPES, RoomClass());
+        for (size_t c = 0; c < courses.size(); ++c) {
+            for (int type = 0; type < ROOM_RULE_TYPES; ++type) {
+                for (size_t k = 0; k < rules.size(); ++k) {
+                    if (!(rules[k].sessionTypes >> type & 1) || !room_rule_match(rules[k].coursePattern, courses[c])) continue;
+                    classes[c * ROOM_RULE_TYPES + type] = { ruleRooms[k], rules[k].minCapacity };
+                    break;
+                }
+            }
+        }
+        return true;
+    }
+
+    uint64_t room_bit(int room) const { return roomBits[room]; }
+    const RoomClass& session_class(int course, int type) const { return classes[(size_t)course * ROOM_RULE_TYPES + type]; }
+
+    // The hot-path check; the room needs a seat per student and the rule's minimum.
+    bool fits(int course, int type, int room, int capacity, int students) const {
+        const RoomClass& c = session_class(course, type);
+        return (roomBits[room] & c.rooms) && capacity >= std::max(students, c.minCapacity);
+    }
+
+private:
+    std::vector<uint64_t> roomBits;      // room -> its class bit, 0 when no rule takes it
+    std::vector<RoomClass> classes;      // course * ROOM_RULE_TYPES + session type
+
+    static std::vector<std::string> split(std::string_view list) {
+        std::vector<std::string> items;
+        size_t start = 0;
+        while (start <= list.size()) {
+            size_t end = std::min(list.find(';', start), list.size());
+            std::string_view item = list.substr(start, end - start);
+            size_t first = item.find_first_not_of(" \t"), last = item.find_last_not_of(" \t");
+            if (first != std::string_view::npos) items.emplace_back(item.substr(first, last - first + 1));
+            start = end + 1;
+        }
+        return items;
+    }
+
+    // 0..3 for one session type, ROOM_RULE_TYPES for "*", -1 when unknown.
+    static int parse_type(const std::string& name) {
+        static const char* names[][2] = { { "LEC", "LECTURE" }, { "TUT", "TUTORIAL" }, { "LAB", "LAB" }, { "OTHER", "OTHER" } };
+        if (name == "*") return ROOM_RULE_TYPES;
+        for (int type = 0; type < ROOM_RULE_TYPES; ++type) {
+            for (const char* n : names[type]) {
+                if (room_rule_match(n, name)) return type;
+            }
+        }
+        return -1;
+    }
+};
@@ -0,0 +1,638 @@
+// sat_engine.h
+// SAT engine shared by both schedulers, as an alternative to their
+// backtracking search. A program describes its problem as a SatTimetable
+// (every session's sections, candidate rooms and candidate teachers; every
+// timeslot is a candidate) and solve_timetable_sat() encodes it into CNF and
+// solves it with CdclSolver, an in-tree CDCL solver: two watched literals
+// with blockers, VSIDS branching with phase saving, first-UIP learning with
+// clause minimization, Luby restarts and LBD-based clause deletion.
+//
+// The encoding is factored: a session has one Boolean per timeslot, per
+// candidate room and per candidate teacher, each group exactly-one (a single
+// candidate needs no variable). A room, section or teacher may hold at most
+// one session per timeslot; a room's sessions at time t are the terms
+// "at t and in the room", and every such at-most-one is a sequential counter
+// (Sinz 2005) whose inputs are these two-literal terms, so no variable is
+// spent per (session, time, room) triple.
+#pragma once
+
+#include <bits/stdc++.h>
+
+// Literals are 2 * variable + negated; variables count from 0.
+typedef uint32_t SatLit;
+const SatLit SAT_NO_LIT = UINT32_MAX;
+
+inline SatLit sat_lit(int var, bool negated = false) { return 2u * (uint32_t)var + negated; }
+inline SatLit sat_neg(SatLit l) { return l ^ 1u; }
+inline int sat_var(SatLit l) { return (int)(l >> 1); }
+
+enum SatResult { SAT_UNKNOWN, SAT_SATISFIABLE, SAT_UNSATISFIABLE };
+
+struct SatStats {
+    int vars = 0;               // of the encoding, counters included
+    size_t clauses = 0;         // problem clauses
+    uint64_t decisions = 0;
+    uint64_t propagations = 0;  // literals assigned by unit propagation
+    uint64_t conflicts = 0;
+    uint64_t restarts = 0;
+    uint64_t learnt = 0;        // clauses learnt
+    uint64_t deleted = 0;       // learnt clauses dropped by reduce_learnts()
+    int maxLevel = 0;
+};
+
+class CdclSolver {
+public:
+    SatStats stats;
+
+    // A variable that is not a decision variable is never branched on; it must
+    // be one whose value propagation fixes whenever it matters (see
+    // at_most_one()), and reads as false in a model when left unassigned.
+    int new_var(bool decision = true) {
+        int v = (int)assigns.size();
+        assigns.push_back(-1);
+        level.push_back(0);
+        reason.push_back(NO_REASON);
+        phase.push_back(0);
+        seen.push_back(0);
+        activity.push_back(0);
+        heapIndex.push_back(-1);
+        watches.emplace_back();
+        watches.emplace_back();
+        decisionVar.push_back(decision);
+        if (decision) heap_insert(v);
+        return v;
+    }
+    int vars() const { return (int)assigns.size(); }
+
+    // Initial polarity and activity of v: variables with a higher activity are
+    // branched on first, until conflicts bump others past them.
+    void prefer(int v, bool value, double initial_activity) {
+        phase[v] = value;
+        activity[v] = initial_activity;
+        if (heapIndex[v] >= 0) heap_up(heapIndex[v]);
+    }
+    size_t clauses() const { return problemClauses; }
+
+    // Adds a clause at decision level 0; false once the formula is known
+    // unsatisfiable.
+    bool add_clause(const std::vector<SatLit>& clause) {
+        if (!ok) return false;
+        std::vector<SatLit>& lits = adding;
+        lits.assign(clause.begin(), clause.end());
+        std::sort(lits.begin(), lits.end());
+        size_t j = 0;
+        for (size_t i = 0; i < lits.size(); ++i) {
+            int v = value(lits[i]);
+            if (v == 1 || (j && lits[i] == sat_neg(lits[j - 1]))) return true;  // satisfied or tautology
+            if (v == 0 || (j && lits[i] == lits[j - 1])) continue;
+            lits[j++] = lits[i];
+        }
+        lits.resize(j);
+        if (lits.empty()) return ok = false;
+        if (lits.size() == 1) {
+            enqueue(lits[0], NO_REASON);
+            return ok = propagate() == NO_REASON;
+        }
+        attach(store(lits, false, 0));
+        ++problemClauses;
+        return true;
+    }
+    bool add_clause(std::initializer_list<SatLit> lits) { return add_clause(std::vector<SatLit>(lits)); }
+
+    // At most one of the terms holds. A term is one literal (second ==
+    // SAT_NO_LIT) or the conjunction of two.
+    void at_most_one(const std::vector<std::pair<SatLit, SatLit>>& terms) {
+        size_t n = terms.size();
+        std::vector<SatLit> clause;
+        auto negated = [&](const std::pair<SatLit, SatLit>& term) {
+            clause.push_back(sat_neg(term.first));
+            if (term.second != SAT_NO_LIT) clause.push_back(sat_neg(term.second));
+        };
+        if (n <= 4) {  // pairwise is smaller than a counter for a handful of terms
+            for (size_t i = 0; i < n; ++i) {
+                for (size_t k = i + 1; k < n; ++k) {
+                    clause.clear();
+                    negated(terms[i]);
+                    negated(terms[k]);
+                    add_clause(clause);
+                }
+            }
+            return;
+        }
+        // register s_i: one of the first i + 1 terms holds. Registers are not
+        // branched on: once the terms are decided, propagation sets every
+        // register after a true term, clears every one before it, and a
+        // register still unassigned can be false.
+        SatLit prev = SAT_NO_LIT;
+        for (size_t i = 0; i < n; ++i) {
+            if (prev != SAT_NO_LIT) {
+                clause.clear();
+                negated(terms[i]);
+                clause.push_back(sat_neg(prev));
+                add_clause(clause);
+            }
+            if (i + 1 == n) break;
+            SatLit reg = sat_lit(new_var(false));
+            clause.clear();
+            negated(terms[i]);
+            clause.push_back(reg);
+            add_clause(clause);
+            if (prev != SAT_NO_LIT) add_clause({ sat_neg(prev), reg });
+            prev = reg;
+        }
+    }
+
+    void exactly_one(const std::vector<SatLit>& lits) {
+        add_clause(lits);
+        std::vector<std::pair<SatLit, SatLit>> terms;
+        for (SatLit l : lits) terms.emplace_back(l, SAT_NO_LIT);
+        at_most_one(terms);
+    }
+
+    // Runs until the formula is decided, conflict_limit more conflicts have
+    // happened or *stop is set. An unfinished call can be resumed; learnt
+    // clauses and activities carry over.
+    SatResult solve(uint64_t conflict_limit = UINT64_MAX, const std::atomic<bool>* stop = nullptr) {
+        if (!ok) return SAT_UNSATISFIABLE;
+        uint64_t limit = conflict_limit == UINT64_MAX ? UINT64_MAX : stats.conflicts + conflict_limit;
+        std::vector<SatLit> learnt;
+        for (;;) {
+            uint32_t conflict = propagate();
+            if (conflict != NO_REASON) {
+                ++stats.conflicts;
+                ++restartConflicts;
+                if (decision_level() == 0) {
+                    ok = false;
+                    return SAT_UNSATISFIABLE;
+                }
+                int back_level, lbd;
+                analyze(conflict, learnt, back_level, lbd);
+                backtrack(back_level);
+                if (learnt.size() == 1) enqueue(learnt[0], NO_REASON);
+                else {
+                    uint32_t cr = store(learnt, true, lbd);
+                    attach(cr);
+                    learnts.push_back(cr);
+                    enqueue(learnt[0], cr);
+                }
+                ++stats.learnt;
+                varInc *= 1 / VAR_DECAY;
+                continue;
+            }
+            if (restartConflicts >= luby(restartCount) * RESTART_UNIT) {
+                restartConflicts = 0;
+                ++restartCount;
+                ++stats.restarts;
+                backtrack(0);
+            }
+            if (learnts.size() >= maxLearnts) {
+                reduce_learnts();
+                maxLearnts += maxLearnts / 10;
+            }
+            if (stats.conflicts >= limit || (stop && stop->load(std::memory_order_relaxed))) {
+                backtrack(0);
+                return SAT_UNKNOWN;
+            }
+            int v = pick_branch();
+            if (v < 0) return SAT_SATISFIABLE;
+            ++stats.decisions;
+            trailLim.push_back((int)trail.size());
+            stats.maxLevel = std::max(stats.maxLevel, decision_level());
+            enqueue(sat_lit(v, !phase[v]), NO_REASON);
+        }
+    }
+
+    // Value of v in the model found by the last satisfiable solve().
+    bool model(int v) const { return assigns[v] == 1; }
+
+private:
+    static constexpr uint32_t NO_REASON = UINT32_MAX;
+    static constexpr double VAR_DECAY = 0.95;
+    static constexpr int RESTART_UNIT = 100;  // conflicts per Luby unit
+
+    struct Watcher {
+        uint32_t cref;
+        SatLit blocker;  // another literal of the clause; a true blocker skips the visit
+    };
+
+    // Clause arena: a header word (size << 2 | learnt << 1 | deleted), the LBD,
+    // then the literals. The first two literals are the watched ones.
+    std::vector<uint32_t> arena;
+    std::vector<uint32_t> learnts;
+    size_t problemClauses = 0;
+    size_t wasted = 0;  // arena words held by deleted clauses
+    size_t maxLearnts = 20000;
+    std::vector<SatLit> adding;  // add_clause() scratch
+
+    std::vector<int8_t> assigns;  // 1 true, 0 false, -1 unassigned
+    std::vector<int> level;
+    std::vector<uint32_t> reason;
+    std::vector<uint8_t> phase;  // saved polarity, 1 = true
+    std::vector<uint8_t> decisionVar;
+    std::vector<uint8_t> seen;
+    std::vector<SatLit> analyzed;  // analyze() scratch: the clause before minimization
+    std::vector<std::vector<Watcher>> watches;  // literal -> clauses watching it
+    std::vector<SatLit> trail;
+    std::vector<int> trailLim;
+    size_t qhead = 0;
+    bool ok = true;
+
+    std::vector<double> activity;
+    double varInc = 1;
+    std::vector<int> heap, heapIndex;  // max-heap of variables by activity
+
+    uint64_t restartConflicts = 0;
+    int restartCount = 0;
+    std::vector<int> levelStamp;
+    int stamp = 0;
+
+    int decision_level() const { return (int)trailLim.size(); }
+    // 1 true, 0 false, -1 unassigned
+    int value(SatLit l) const {
+        int a = assigns[sat_var(l)];
+        return a < 0 ? -1 : a ^ (int)(l & 1);
+    }
+    uint32_t size_of(uint32_t cr) const { return arena[cr] >> 2; }
+    bool learnt_clause(uint32_t cr) const { return arena[cr] & 2; }
+    bool deleted(uint32_t cr) const { return arena[cr] & 1; }
+    SatLit* lits(uint32_t cr) { return arena.data() + cr + 2; }
+
+    uint32_t store(const std::vector<SatLit>& c, bool learnt, int lbd) {
+        uint32_t cr = (uint32_t)arena.size();
+        arena.push_back((uint32_t)c.size() << 2 | (uint32_t)learnt << 1);
+        arena.push_back((uint32_t)lbd);
+        arena.insert(arena.end(), c.begin(), c.end());
+        return cr;
+    }
+    void attach(uint32_t cr) {
+        SatLit* c = lits(cr);
+        watches[c[0]].push_back({ cr, c[1] });
+        watches[c[1]].push_back({ cr, c[0] });
+    }
+
+    void enqueue(SatLit l, uint32_t from) {
+        int v = sat_var(l);
+        assigns[v] = !(l & 1);
+        level[v] = decision_level();
+        reason[v] = from;
+        trail.push_back(l);
+    }
+
+    // Returns a conflicting clause or NO_REASON.
+    uint32_t propagate() {
+        uint32_t conflict = NO_REASON;
+        while (qhead < trail.size()) {
+            SatLit false_lit = sat_neg(trail[qhead++]);
+            std::vector<Watcher>& ws = watches[false_lit];
+            size_t i = 0, j = 0, n = ws.size();
+            while (i < n) {
+                Watcher w = ws[i++];
+                if (value(w.blocker) == 1) {
+                    ws[j++] = w;
+                    continue;
+                }
+                SatLit* c = lits(w.cref);
+                if (c[0] == false_lit) std::swap(c[0], c[1]);
+                SatLit first = c[0];
+                if (first != w.blocker && value(first) == 1) {
+                    ws[j++] = { w.cref, first };
+                    continue;
+                }
+                uint32_t size = size_of(w.cref);
+                bool moved = false;
+                for (uint32_t k = 2; k < size; ++k) {
+                    if (value(c[k]) != 0) {
+                        c[1] = c[k];
+                        c[k] = false_lit;
+                        watches[c[1]].push_back({ w.cref, first });
+                        moved = true;
+                        break;
+                    }
+                }
+                if (moved) continue;
+                ws[j++] = { w.cref, first };
+                if (value(first) == 0) {
+                    conflict = w.cref;
+                    qhead = trail.size();
+                    while (i < n) ws[j++] = ws[i++];
+                }
+                else {
+                    enqueue(first, w.cref);
+                    ++stats.propagations;
+                }
+            }
+            ws.resize(j);
+        }
+        return conflict;
+    }
+
+    // First-UIP clause of a conflict, minimized by dropping literals implied
+    // by the others; learnt[1] holds the literal of the backjump level.
+    void analyze(uint32_t conflict, std::vector<SatLit>& learnt, int& back_level, int& lbd) {
+        learnt.assign(1, SAT_NO_LIT);
+        int paths = 0;
+        SatLit p = SAT_NO_LIT;
+        size_t index = trail.size();
+        uint32_t cr = conflict;
+        do {
+            SatLit* c = lits(cr);
+            uint32_t size = size_of(cr);
+            for (uint32_t k = p == SAT_NO_LIT ? 0 : 1; k < size; ++k) {
+                int v = sat_var(c[k]);
+                if (seen[v] || level[v] == 0) continue;
+                seen[v] = 1;
+                bump(v);
+                if (level[v] >= decision_level()) ++paths;
+                else learnt.push_back(c[k]);
+            }
+            while (!seen[sat_var(trail[--index])]) {}
+            p = trail[index];
+            cr = reason[sat_var(p)];
+            seen[sat_var(p)] = 0;
+            --paths;
+        } while (paths > 0);
+        learnt[0] = sat_neg(p);
+
+        analyzed.assign(learnt.begin(), learnt.end());
+        size_t j = 1;
+        for (size_t i = 1; i < learnt.size(); ++i) {
+            uint32_t from = reason[sat_var(learnt[i])];
+            bool implied = from != NO_REASON;
+            if (implied) {
+                SatLit* c = lits(from);
+                for (uint32_t k = 1; k < size_of(from) && implied; ++k) {
+                    int v = sat_var(c[k]);
+                    implied = seen[v] || level[v] == 0;
+                }
+            }
+            if (!implied) learnt[j++] = learnt[i];
+        }
+        learnt.resize(j);
+        for (size_t i = 1; i < analyzed.size(); ++i) seen[sat_var(analyzed[i])] = 0;
+
+        back_level = 0;
+        size_t at = 1;
+        for (size_t i = 1; i < learnt.size(); ++i) {
+            if (level[sat_var(learnt[i])] > back_level) {
+                back_level = level[sat_var(learnt[i])];
+                at = i;
+            }
+        }
+        if (learnt.size() > 1) std::swap(learnt[1], learnt[at]);
+
+        levelStamp.resize(decision_level() + 1, 0);
+        ++stamp;
+        lbd = 0;
+        for (SatLit l : learnt) {
+            int& s = levelStamp[level[sat_var(l)]];
+            if (s != stamp) {
+                s = stamp;
+                ++lbd;
+            }
+        }
+    }
+
+    void backtrack(int to) {
+        if (decision_level() <= to) return;
+        for (size_t i = trail.size(); i-- > (size_t)trailLim[to];) {
+            int v = sat_var(trail[i]);
+            phase[v] = assigns[v] == 1;
+            assigns[v] = -1;
+            reason[v] = NO_REASON;
+            if (heapIndex[v] < 0 && decisionVar[v]) heap_insert(v);
+        }
+        trail.resize(trailLim[to]);
+        trailLim.resize(to);
+        qhead = trail.size();
+    }
+
+    // Drops the worse half of the learnt clauses by LBD, keeping glue clauses
+    // (LBD 2) and clauses that are the reason of an assignment.
+    void reduce_learnts() {
+        std::sort(learnts.begin(), learnts.end(), [&](uint32_t a, uint32_t b) {
+            return arena[a + 1] != arena[b + 1] ? arena[a + 1] > arena[b + 1] : size_of(a) > size_of(b);
+        });
+        size_t j = 0, half = learnts.size() / 2;
+        for (size_t i = 0; i < learnts.size(); ++i) {
+            uint32_t cr = learnts[i];
+            SatLit first = lits(cr)[0];
+            bool locked = reason[sat_var(first)] == cr && value(first) == 1;
+            if (i < half && arena[cr + 1] > 2 && !locked) {
+                arena[cr] |= 1;
+                wasted += size_of(cr) + 2;
+                ++stats.deleted;
+            }
+            else learnts[j++] = cr;
+        }
+        learnts.resize(j);
+        for (auto& ws : watches) {
+            ws.erase(std::remove_if(ws.begin(), ws.end(), [&](const Watcher& w) { return deleted(w.cref); }), ws.end());
+        }
+        if (wasted * 2 > arena.size()) compact();
+    }
+
+    // Copies live clauses into a fresh arena and renumbers every reference.
+    void compact() {
+        std::vector<uint32_t> fresh;
+        fresh.reserve(arena.size() - wasted);
+        for (uint32_t cr = 0; cr < arena.size();) {
+            uint32_t words = size_of(cr) + 2;
+            if (!deleted(cr)) {
+                uint32_t to = (uint32_t)fresh.size();
+                fresh.insert(fresh.end(), arena.begin() + cr, arena.begin() + cr + words);
+                arena[cr + 1] = to;  // forwarding address
+            }
+            cr += words;
+        }
+        for (auto& ws : watches) {
+            for (auto& w : ws) w.cref = arena[w.cref + 1];
+        }
+        for (SatLit l : trail) {
+            uint32_t& r = reason[sat_var(l)];
+            if (r != NO_REASON) r = arena[r + 1];
+        }
+        for (auto& cr : learnts) cr = arena[cr + 1];
+        arena.swap(fresh);
+        wasted = 0;
+    }
+
+    static double luby(int x) {
+        int size = 1, seq = 0;
+        while (size < x + 1) {
+            ++seq;
+            size = 2 * size + 1;
+        }
+        while (size - 1 != x) {
+            size = (size - 1) >> 1;
+            --seq;
+            x %= size;
+        }
+        return std::pow(2.0, seq);
+    }
+
+    void bump(int v) {
+        if ((activity[v] += varInc) > 1e100) {
+            for (double& a : activity) a *= 1e-100;
+            varInc *= 1e-100;
+        }
+        if (heapIndex[v] >= 0) heap_up(heapIndex[v]);
+    }
+
+    int pick_branch() {
+        while (!heap.empty()) {
+            int v = heap_pop();
+            if (assigns[v] < 0) return v;
+        }
+        return -1;
+    }
+
+    void heap_insert(int v) {
+        heapIndex[v] = (int)heap.size();
+        heap.push_back(v);
+        heap_up(heapIndex[v]);
+    }
+    void heap_up(int i) {
+        int v = heap[i];
+        while (i > 0) {
+            int parent = (i - 1) / 2;
+            if (activity[heap[parent]] >= activity[v]) break;
+            heap[i] = heap[parent];
+            heapIndex[heap[i]] = i;
+            i = parent;
+        }
+        heap[i] = v;
+        heapIndex[v] = i;
+    }
+    int heap_pop() {
+        int top = heap[0];
+        heapIndex[top] = -1;
+        int v = heap.back();
+        heap.pop_back();
+        if (heap.empty()) return top;
+        int i = 0, n = (int)heap.size();
+        for (;;) {
+            int child = 2 * i + 1;
+            if (child >= n) break;
+            if (child + 1 < n && activity[heap[child + 1]] > activity[heap[child]]) ++child;
+            if (activity[heap[child]] <= activity[v]) break;
+            heap[i] = heap[child];
+            heapIndex[heap[i]] = i;
+            i = child;
+        }
+        heap[i] = v;
+        heapIndex[v] = i;
+        return top;
+    }
+};
+
+// A timetabling problem in the form the encoding takes: sessions with their
+// sections and candidate rooms and teachers, as offsets into shared pools.
+// Teachers are keys over every teacher the program has, so two sessions with
+// the same key can never share a timeslot.
+struct SatTimetable {
+    int times = 0, rooms = 0, sections = 0, teachers = 0;
+    std::vector<int> sectionStart, roomStart, teacherStart;  // session -> offset into the pool, size sessions + 1
+    std::vector<int> sectionPool, roomPool, teacherPool;
+
+    int sessions() const { return (int)roomStart.size() - 1; }
+};
+
+// Placement of every session as (time, room, teacher key).
+typedef std::array<int, 3> SatPlacement;
+
+// Encodes and solves t. report is called every report_interval conflicts with
+// the solver's counters; a true return from it stops the search with
+// SAT_UNKNOWN, as does running past conflict_limit.
+inline SatResult solve_timetable_sat(const SatTimetable& t, std::vector<SatPlacement>& placement, SatStats& stats,
+    uint64_t conflict_limit, const std::function<bool(const SatStats&)>& report,
+    uint64_t report_interval = 2000) {
+    CdclSolver solver;
+    int n = t.sessions();
+    // variable of session s at time k is timeVar[s] + k; room and teacher
+    // variables follow their pool order, -1 when a single candidate is fixed
+    std::vector<int> timeVar(n), roomVar(n, -1), teacherVar(n, -1);
+    std::vector<SatLit> group;
+    for (int s = 0; s < n; ++s) {
+        timeVar[s] = solver.vars();
+        for (int k = 0; k < t.times; ++k) solver.new_var();
+        int room_count = t.roomStart[s + 1] - t.roomStart[s], teacher_count = t.teacherStart[s + 1] - t.teacherStart[s];
+        if (room_count > 1) {
+            roomVar[s] = solver.vars();
+            for (int k = 0; k < room_count; ++k) solver.new_var();
+        }
+        if (teacher_count > 1) {
+            teacherVar[s] = solver.vars();
+            for (int k = 0; k < teacher_count; ++k) solver.new_var();
+        }
+        std::pair<int, int> groups[3] = { { timeVar[s], t.times }, { roomVar[s], room_count }, { teacherVar[s], teacher_count } };
+        for (auto [base, count] : groups) {
+            if (base < 0) {
+                if (count == 0) solver.add_clause(std::vector<SatLit>());  // no candidate at all
+                continue;
+            }
+            group.clear();
+            for (int k = 0; k < count; ++k) {
+                group.push_back(sat_lit(base + k));
+                // decide placements, first candidates first; the counters follow by propagation
+                solver.prefer(base + k, true, 1.0 / (k + 1));
+            }
+            solver.exactly_one(group);
+        }
+    }
+
+    // at most one session per (time, resource); a resource's candidates are
+    // listed once with the literal choosing it (SAT_NO_LIT when fixed)
+    auto exclusive = [&](int resources, auto candidates) {
+        std::vector<std::vector<std::pair<int, SatLit>>> users(resources);
+        for (int s = 0; s < n; ++s) candidates(s, users);
+        std::vector<std::pair<SatLit, SatLit>> terms;
+        for (const auto& list : users) {
+            if (list.size() < 2) continue;
+            for (int k = 0; k < t.times; ++k) {
+                terms.clear();
+                for (const auto& [s, chosen] : list) terms.emplace_back(sat_lit(timeVar[s] + k), chosen);
+                solver.at_most_one(terms);
+            }
+        }
+    };
+    exclusive(t.sections, [&](int s, auto& users) {
+        for (int i = t.sectionStart[s]; i < t.sectionStart[s + 1]; ++i) users[t.sectionPool[i]].emplace_back(s, SAT_NO_LIT);
+    });
+    exclusive(t.rooms, [&](int s, auto& users) {
+        for (int i = t.roomStart[s]; i < t.roomStart[s + 1]; ++i) {
+            users[t.roomPool[i]].emplace_back(s, roomVar[s] < 0 ? SAT_NO_LIT : sat_lit(roomVar[s] + i - t.roomStart[s]));
+        }
+    });
+    exclusive(t.teachers, [&](int s, auto& users) {
+        for (int i = t.teacherStart[s]; i < t.teacherStart[s + 1]; ++i) {
+            users[t.teacherPool[i]].emplace_back(s, teacherVar[s] < 0 ? SAT_NO_LIT : sat_lit(teacherVar[s] + i - t.teacherStart[s]));
+        }
+    });
+
+    solver.stats.vars = solver.vars();
+    solver.stats.clauses = solver.clauses();
+    SatResult result = SAT_UNKNOWN;
+    while (result == SAT_UNKNOWN) {
+        uint64_t chunk = std::min(report_interval, conflict_limit - std::min(conflict_limit, solver.stats.conflicts));
+        if (chunk == 0) break;
+        result = solver.solve(chunk);
+        if (result == SAT_UNKNOWN && report && report(solver.stats)) break;
+    }
+    stats = solver.stats;
+    if (result != SAT_SATISFIABLE) return result;
+
+    placement.assign(n, { -1, -1, -1 });
+    auto chosen = [&](int base, int count) {
+        if (base < 0) return 0;
+        for (int k = 0; k < count; ++k) {
+            if (solver.model(base + k)) return k;
+        }
+        return -1;
+    };
+    for (int s = 0; s < n; ++s) {
+        placement[s][0] = chosen(timeVar[s], t.times);
+        placement[s][1] = t.roomPool[t.roomStart[s] + chosen(roomVar[s], t.roomStart[s + 1] - t.roomStart[s])];
+        placement[s][2] = t.teacherPool[t.teacherStart[s] + chosen(teacherVar[s], t.teacherStart[s + 1] - t.teacherStart[s])];
+    }
+    return result;
+}
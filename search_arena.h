@@ -0,0 +1,154 @@
+// search_arena.h
+// Fixed-size search memory shared by both schedulers. A search allocates what
+// its loop needs when it is set up, sized from the number of sessions, and
+// then only reuses it: each program's trail, explicit stack frames and
+// conflict sets, and the nogood store below, keep their storage from one
+// search to the next. Linking alloc_counter.cpp in shows in the stats that the
+// loop allocates nothing.
+#pragma once
+
+#include <bits/stdc++.h>
+
+// Bounded store of learned nogoods: sets of placement keys that cannot all hold
+// in one solution. A key carries its variable in the bits from 40 up. Each
+// nogood is indexed under every key it contains, and when the store is full a
+// clock hand evicts the first nogood that has not been hit since the hand last
+// passed it. Nogoods sit in fixed-width slots of one key array, and the index
+// is a hash table chained through those keys; a chain is appended at its tail,
+// so nogoods sharing a key are checked oldest first.
+class NogoodStore {
+public:
+    size_t capacity = 1 << 15;   // nogoods; fixed by the first clear()
+    size_t maxLength = 16;       // keys per nogood
+    size_t hand = 0;             // clock hand
+
+    struct Keys {
+        const uint64_t* first;
+        const uint64_t* last;
+        const uint64_t* begin() const { return first; }
+        const uint64_t* end() const { return last; }
+        size_t size() const { return last - first; }
+    };
+
+    // Empties the store; the first call allocates it.
+    void clear() {
+        if (!store) {
+            // key slots are written before they are read, so they start out uninitialized
+            store.reset(new uint64_t[capacity * maxLength]);
+            next.reset(new int[capacity * maxLength]);
+            lengths.resize(capacity);
+            hits.resize(capacity);
+            size_t buckets = 1;
+            while (buckets < capacity * 4) buckets <<= 1;
+            head.assign(buckets, -1);
+            shift = 64 - __builtin_ctzll(buckets);
+        }
+        else {
+            for (size_t slot = 0; slot < used; ++slot) {
+                for (uint64_t key : nogood(slot)) head[bucket(key)] = -1;
+            }
+        }
+        used = 0;
+        hand = 0;
+    }
+
+    size_t size() const { return used; }  // slots in use
+    Keys nogood(size_t slot) const {
+        const uint64_t* first = store.get() + slot * maxLength;
+        return { first, first + lengths[slot] };
+    }
+    bool referenced(size_t slot) const { return hits[slot]; }
+
+    // Stores the nogood of keys key_of(0) .. key_of(length - 1). False if it
+    // was not stored (empty or longer than maxLength).
+    template <class KeyOf> bool add(size_t length, KeyOf key_of) {
+        if (length == 0 || length > maxLength) return false;
+        size_t slot;
+        if (used < capacity) slot = used++;
+        else {
+            while (hits[hand]) {
+                hits[hand] = 0;
+                hand = (hand + 1) % capacity;
+            }
+            slot = hand;
+            hand = (hand + 1) % capacity;
+            unlink(slot);
+        }
+        link(slot, length, key_of);
+        return true;
+    }
+
+    // The first nogood under key all of whose keys hold, or -1. A hit marks it
+    // referenced for the clock.
+    template <class Holds> int violated(uint64_t key, Holds holds) {
+        for (int e = head[bucket(key)]; e >= 0; e = next[e]) {
+            if (store[e] != key) continue;
+            size_t slot = e / maxLength;
+            bool all = true;
+            for (uint64_t k : nogood(slot)) {
+                if (!holds(k)) {
+                    all = false;
+                    break;
+                }
+            }
+            if (all) {
+                hits[slot] = 1;
+                return slot;
+            }
+        }
+        return -1;
+    }
+
+    // Takes over the nogoods (lengths, then all keys back to back) and clock
+    // of a saved store. False, leaving the store alone, if they do not fit.
+    bool restore(const std::vector<uint32_t>& saved_lengths, const std::vector<uint64_t>& saved_keys,
+        const std::vector<uint8_t>& saved_hits, size_t saved_hand) {
+        if (saved_lengths.size() > capacity || saved_hits.size() != saved_lengths.size() || saved_hand >= capacity) return false;
+        size_t total = 0;
+        for (uint32_t length : saved_lengths) {
+            if (length == 0 || length > maxLength) return false;
+            total += length;
+        }
+        if (total != saved_keys.size()) return false;
+        clear();
+        for (size_t at = 0; used < saved_lengths.size(); at += saved_lengths[used++]) {
+            link(used, saved_lengths[used], [&](size_t i) { return saved_keys[at + i]; });
+            hits[used] = saved_hits[used];
+        }
+        hand = saved_hand;
+        return true;
+    }
+
+private:
+    std::unique_ptr<uint64_t[]> store;  // slot * maxLength + i -> key
+    std::unique_ptr<int[]> next;        // same index -> next entry of its chain, -1 at the tail
+    std::vector<uint32_t> lengths; // slot -> keys in it
+    std::vector<uint8_t> hits;     // slot -> hit since the clock hand last passed it
+    std::vector<int> head;         // bucket -> first entry, -1 if empty
+    int shift = 64;
+    size_t used = 0;
+
+    size_t bucket(uint64_t key) const { return (key * 0x9E3779B97F4A7C15ULL) >> shift; }
+
+    template <class KeyOf> void link(size_t slot, size_t length, KeyOf key_of) {
+        lengths[slot] = length;
+        hits[slot] = 0;
+        for (size_t i = 0; i < length; ++i) {
+            int e = slot * maxLength + i;
+            store[e] = key_of(i);
+            next[e] = -1;
+            int* tail = &head[bucket(store[e])];
+            while (*tail >= 0) tail = &next[*tail];
+            *tail = e;
+        }
+    }
+
+    void unlink(size_t slot) {
+        for (size_t i = 0; i < lengths[slot]; ++i) {
+            int e = slot * maxLength + i;
+            int* link = &head[bucket(store[e])];
+            while (*link != e) link = &next[*link];
+            *link = next[e];
+        }
+    }
+};
@@ -0,0 +1,165 @@
+// search_stats.h
+// Search instrumentation shared by both schedulers. Every search thread counts
+// into its own SearchStats with plain increments, so the counters cost next to
+// nothing whether or not anything reads them. Every few thousand nodes a thread
+// publishes a copy to the ProgressReporter, whose own thread prints one stderr
+// line per interval while --progress is on. PhaseTimer holds per-phase wall
+// times, and both end up in the JSON dump written by --stats.
+#pragma once
+
+#include <bits/stdc++.h>
+
+// What made a placement fail: the students' section, the room, the teacher, or
+// a learned nogood.
+enum ConflictKind : uint8_t { CONFLICT_SECTION, CONFLICT_ROOM, CONFLICT_TEACHER, CONFLICT_NOGOOD, CONFLICT_KINDS };
+
+inline const char* conflict_kind_name(int kind) {
+    static const char* names[CONFLICT_KINDS] = { "section", "room", "teacher", "nogood" };
+    return names[kind];
+}
+
+// Heap allocations the calling thread has made so far. This weak default
+// reports none; alloc_counter.cpp, when linked in, counts them.
+__attribute__((weak)) uint64_t thread_allocations() { return 0; }
+
+struct SearchStats {
+    uint64_t nodes = 0;           // placements tried
+    uint64_t backtracks = 0;      // levels exhausted
+    uint64_t backjumps = 0;       // levels skipped by conflict-directed backjumping
+    uint64_t failures[CONFLICT_KINDS] = {};  // failed placements by cause
+    uint64_t propagations = 0;    // forward-checking passes
+    uint64_t prunings = 0;        // values removed from domains
+    uint64_t nogoodsLearned = 0;
+    uint64_t allocations = 0;     // heap allocations inside the search loop, see alloc_counter.cpp
+    int maxDepth = 0;
+
+    void add(const SearchStats& o) {
+        nodes += o.nodes;
+        backtracks += o.backtracks;
+        backjumps += o.backjumps;
+        for (int k = 0; k < CONFLICT_KINDS; ++k) failures[k] += o.failures[k];
+        propagations += o.propagations;
+        prunings += o.prunings;
+        nogoodsLearned += o.nogoodsLearned;
+        allocations += o.allocations;
+        maxDepth = std::max(maxDepth, o.maxDepth);
+    }
+
+    void write_json(std::ostream& out) const {
+        out << "{\"nodes\": " << nodes << ", \"backtracks\": " << backtracks << ", \"backjumps\": " << backjumps
+            << ", \"failures\": {";
+        for (int k = 0; k < CONFLICT_KINDS; ++k) out << (k ? ", " : "") << '"' << conflict_kind_name(k) << "\": " << failures[k];
+        out << "}, \"propagations\": " << propagations << ", \"prunings\": " << prunings
+            << ", \"nogoods_learned\": " << nogoodsLearned << ", \"allocations\": " << allocations
+            << ", \"max_depth\": " << maxDepth << "}";
+    }
+};
+
+// Wall-clock times of consecutive phases, in milliseconds.
+struct PhaseTimer {
+    std::vector<std::pair<std::string, double>> phases;
+    std::chrono::steady_clock::time_point lapStart = std::chrono::steady_clock::now();
+
+    // Ends the running phase and records it under name (added to an earlier
+    // phase of the same name); returns its time.
+    double lap(const std::string& name) {
+        auto now = std::chrono::steady_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(now - lapStart).count();
+        lapStart = now;
+        for (auto& [phase, total] : phases) {
+            if (phase == name) {
+                total += ms;
+                return ms;
+            }
+        }
+        phases.emplace_back(name, ms);
+        return ms;
+    }
+    double get(const std::string& name) const {
+        for (const auto& [phase, total] : phases) {
+            if (phase == name) return total;
+        }
+        return 0;
+    }
+    void write_json(std::ostream& out) const {
+        out << "{";
+        for (size_t i = 0; i < phases.size(); ++i) out << (i ? ", " : "") << '"' << phases[i].first << "\": " << phases[i].second;
+        out << "}";
+    }
+};
+
+// Prints a progress line to stderr every interval from its own thread, from the
+// counters the search threads last published.
+class ProgressReporter {
+public:
+    // Number of nodes between two publish() calls of a search thread.
+    static const uint64_t PUBLISH_MASK = 4095;
+
+    bool enabled() const { return active; }
+
+    // No-op unless seconds > 0. variables is the search depth of a full solution.
+    void start(double seconds, int workers, int variables) {
+        if (seconds <= 0) return;
+        interval = seconds;
+        total = variables;
+        latest.assign(std::max(1, workers), {});
+        depth.assign(latest.size(), 0);
+        begin = std::chrono::steady_clock::now();
+        active = true;
+        reporter = std::thread([this] { run(); });
+    }
+    void stop() {
+        if (!active) return;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            active = false;
+        }
+        wake.notify_all();
+        reporter.join();
+    }
+    ~ProgressReporter() { stop(); }
+
+    void publish(int worker, const SearchStats& stats, int current_depth) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (worker < 0 || worker >= (int)latest.size()) return;
+        latest[worker] = stats;
+        depth[worker] = current_depth;
+    }
+
+private:
+    double interval = 0;
+    int total = 0;
+    bool active = false;
+    std::vector<SearchStats> latest;
+    std::vector<int> depth;
+    std::chrono::steady_clock::time_point begin;
+    std::mutex lock;
+    std::condition_variable wake;
+    std::thread reporter;
+
+    void run() {
+        std::unique_lock<std::mutex> guard(lock);
+        auto next = begin;
+        for (;;) {
+            next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(interval));
+            if (wake.wait_until(guard, next, [this] { return !active; })) return;
+            SearchStats sum;
+            int deepest = 0;
+            for (size_t w = 0; w < latest.size(); ++w) {
+                sum.add(latest[w]);
+                deepest = std::max(deepest, depth[w]);
+            }
+            double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+            char line[320];
+            snprintf(line, sizeof line,
+                "[%8.1fs] nodes %llu (%.0f/s) depth %d/%d max %d backtracks %llu backjumps %llu"
+                " failures section %llu room %llu teacher %llu nogood %llu prunings %llu\n",
+                elapsed, (unsigned long long)sum.nodes, sum.nodes / std::max(elapsed, 1e-9), deepest, total, sum.maxDepth,
+                (unsigned long long)sum.backtracks, (unsigned long long)sum.backjumps,
+                (unsigned long long)sum.failures[CONFLICT_SECTION], (unsigned long long)sum.failures[CONFLICT_ROOM],
+                (unsigned long long)sum.failures[CONFLICT_TEACHER], (unsigned long long)sum.failures[CONFLICT_NOGOOD],
+                (unsigned long long)sum.prunings);
+            std::cerr << line << std::flush;
+        }
+    }
+};
@@ -0,0 +1,165 @@
+// snapshot_io.h
+// Versioned binary snapshots of a compiled problem, shared by both schedulers.
+// A snapshot is a fixed header (magic, program tag, format version, content
+// hash of the source tables, payload size) followed by 8-byte aligned
+// sections: trivially copyable arrays written as a count plus raw bytes, and
+// string tables written as an offset array plus one character block. Reading
+// maps the file and copies each array out with one memcpy; nothing is parsed.
+// A snapshot whose tag, version or source hash differs is rejected, so edits
+// to the inputs invalidate it automatically.
+#pragma once
+
+#include "csv_reader.h"
+
+// FNV-1a over a byte range, chained through h.
+inline uint64_t fnv1a(const char* data, size_t size, uint64_t h = 1469598103934665603ULL) {
+    for (size_t i = 0; i < size; ++i) {
+        h ^= (unsigned char)data[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+// Content hash of a list of files; a missing file hashes differently from an
+// empty one.
+inline uint64_t hash_files(const std::vector<std::string>& paths) {
+    uint64_t h = fnv1a("sources", 7);
+    for (const auto& path : paths) {
+        h = fnv1a(path.data(), path.size(), h);
+        MappedFile file;
+        if (!file.open(path)) {
+            h = fnv1a("\0missing", 8, h);
+            continue;
+        }
+        uint64_t size = file.size();
+        h = fnv1a(reinterpret_cast<const char*>(&size), sizeof size, h);
+        h = fnv1a(file.data(), file.size(), h);
+    }
+    return h;
+}
+
+struct SnapshotHeader {
+    char magic[8];
+    char tag[4];
+    uint32_t version;
+    uint64_t sourceHash;
+    uint64_t payloadSize;
+};
+
+class SnapshotWriter {
+public:
+    template <class T> void value(const T& v) {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshot values must be trivially copyable");
+        append(&v, sizeof v);
+    }
+    template <class T> void array(const std::vector<T>& v) {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshot arrays must be trivially copyable");
+        value<uint64_t>(v.size());
+        append(v.data(), v.size() * sizeof(T));
+    }
+    void strings(const std::vector<std::string>& v) {
+        std::vector<uint64_t> offsets{ 0 };
+        for (const auto& s : v) offsets.push_back(offsets.back() + s.size());
+        array(offsets);
+        for (const auto& s : v) payload.append(s);
+        pad();
+    }
+
+    // Writes header and payload to a temporary file renamed over path, so a
+    // reader never sees a half-written snapshot.
+    bool save(const std::string& path, const char tag[4], uint32_t version, uint64_t source_hash) const {
+        SnapshotHeader header = {};
+        memcpy(header.magic, "TTSNAPv1", 8);
+        memcpy(header.tag, tag, 4);
+        header.version = version;
+        header.sourceHash = source_hash;
+        header.payloadSize = payload.size();
+        std::string tmp = path + ".tmp";
+        FILE* f = fopen(tmp.c_str(), "wb");
+        if (!f) return false;
+        bool ok = fwrite(&header, sizeof header, 1, f) == 1 &&
+            fwrite(payload.data(), 1, payload.size(), f) == payload.size();
+        ok = fclose(f) == 0 && ok;
+        if (!ok || rename(tmp.c_str(), path.c_str()) != 0) {
+            remove(tmp.c_str());
+            return false;
+        }
+        return true;
+    }
+
+private:
+    std::string payload;
+
+    void append(const void* data, size_t size) {
+        payload.append(static_cast<const char*>(data), size);
+        pad();
+    }
+    void pad() { payload.resize((payload.size() + 7) & ~size_t(7), '\0'); }
+};
+
+class SnapshotReader {
+public:
+    // Maps path and checks its header; false if it is missing or stale.
+    bool open(const std::string& path, const char tag[4], uint32_t version, uint64_t source_hash) {
+        if (!file.open(path) || file.size() < sizeof(SnapshotHeader)) return false;
+        SnapshotHeader header;
+        memcpy(&header, file.data(), sizeof header);
+        if (memcmp(header.magic, "TTSNAPv1", 8) != 0 || memcmp(header.tag, tag, 4) != 0 ||
+            header.version != version || header.sourceHash != source_hash ||
+            header.payloadSize != file.size() - sizeof header) return false;
+        cursor = file.data() + sizeof header;
+        end = file.data() + file.size();
+        ok = true;
+        return true;
+    }
+    // False once any read ran past the end of the payload.
+    bool good() const { return ok; }
+
+    template <class T> void value(T& v) {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshot values must be trivially copyable");
+        take(&v, sizeof v);
+    }
+    template <class T> void array(std::vector<T>& v) {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshot arrays must be trivially copyable");
+        uint64_t count = 0;
+        value(count);
+        if (!ok || count > (uint64_t)(end - cursor) / sizeof(T)) {
+            ok = false;
+            v.clear();
+            return;
+        }
+        v.resize(count);
+        take(v.data(), count * sizeof(T));
+    }
+    void strings(std::vector<std::string>& v) {
+        std::vector<uint64_t> offsets;
+        array(offsets);
+        v.clear();
+        if (!ok || offsets.empty() || offsets.back() > (uint64_t)(end - cursor)) {
+            ok = false;
+            return;
+        }
+        v.reserve(offsets.size() - 1);
+        for (size_t i = 0; i + 1 < offsets.size(); ++i) v.emplace_back(cursor + offsets[i], offsets[i + 1] - offsets[i]);
+        skip(offsets.back());
+    }
+
+private:
+    MappedFile file;
+    const char* cursor = nullptr;
+    const char* end = nullptr;
+    bool ok = false;
+
+    void take(void* out, size_t size) {
+        if (!ok || size > (size_t)(end - cursor)) {
+            ok = false;
+            return;
+        }
+        if (size) memcpy(out, cursor, size);
+        skip(size);
+    }
+    void skip(size_t size) {
+        size_t padded = (size + 7) & ~size_t(7);
+        cursor += std::min(padded, (size_t)(end - cursor));
+    }
+};
@@ -0,0 +1,26 @@
+// soft_weights.h
+// ConsoleApplication1's soft constraints as --optimize scores them and the
+// verifier reports them: the weights of the cost, and the timeslots a
+// teacher's PreferredSlots names.
+#pragma once
+
+#include <bits/stdc++.h>
+
+const int PREFERENCE_WEIGHT = 50;  // per session outside its teacher's preferred slots
+const int GAP_WEIGHT = 30;         // per idle slot between a section's sessions in a day
+const int WASTE_WEIGHT = 1;        // per empty seat
+const int LOAD_WEIGHT = 40;        // per session above MAX_DAILY_LOAD in a teacher's day
+const int MAX_DAILY_LOAD = 3;
+
+// Calls visit(t) for each timeslot one token names: the slot with that id when
+// the token is all digits, else every slot on the day it names, case aside. A
+// number too long for an int names none.
+template <class TimeSlot, class Visit>
+void for_slot_token(const std::vector<TimeSlot>& slots, const std::string& token, Visit visit) {
+    bool numeric = !token.empty() && std::all_of(token.begin(), token.end(), [](unsigned char c) { return isdigit(c); });
+    int id = 0;
+    if (numeric && std::from_chars(token.data(), token.data() + token.size(), id).ec != std::errc()) return;
+    for (int t = 0; t < (int)slots.size(); ++t) {
+        if (numeric ? slots[t].id == id : strcasecmp(slots[t].day.c_str(), token.c_str()) == 0) visit(t);
+    }
+}
@@ -0,0 +1,409 @@
+// timetable_export.h
+// Timetable export shared by both schedulers. A program hands over its solved
+// timetable as one ExportSession per session, with every name resolved once
+// into flat tables, and write_exports() writes three views of it: per section
+// (the students' week), per teacher and per room. Each view is written as CSV
+// (one row per session), JSON (sessions grouped per section, teacher or room)
+// and iCalendar (weekly recurring events). Sessions are bucketed by key and
+// timeslot with counting sorts, and every file goes out through one buffered
+// writer, so an export costs a few passes over the sessions.
+#pragma once
+
+#include <bits/stdc++.h>
+#include <sys/stat.h>
+
+struct ExportSlot {
+    std::string id, day, start, end;
+};
+
+struct ExportSession {
+    int slot, section, course, room, teacher;
+    const char* type;  // Lecture, Tutorial, LAB, ...
+};
+
+struct TimetableExport {
+    std::vector<ExportSlot> slots;  // in the order a week runs through them
+    std::vector<std::string> sections, courses, rooms, teachers;
+    std::vector<std::string> teacherRoles;  // teacher -> Instructor or TA
+    // Sessions attended by several sections name a label listed after the
+    // sections proper; label sections.size() - sharedSections.size() + i
+    // stands for the sections in sharedSections[i]. The sections view lists
+    // such a session under each of them.
+    std::vector<std::vector<int>> sharedSections;
+    std::vector<ExportSession> sessions;
+};
+
+struct ExportOptions {
+    bool csv = true, json = true, ics = true;
+    int64_t weekStart = 0;  // days since 1970-01-01 of the first day events may fall on
+};
+
+// Days since 1970-01-01 of a proleptic Gregorian date (H. Hinnant's algorithm).
+inline int64_t days_from_civil(int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    unsigned yoe = (unsigned)(y - era * 400);
+    unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int64_t)doe - 719468;
+}
+
+inline void civil_from_days(int64_t z, int& y, int& m, int& d) {
+    z += 719468;
+    int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    unsigned doe = (unsigned)(z - era * 146097);
+    unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    unsigned mp = (5 * doy + 2) / 153;
+    d = (int)(doy - (153 * mp + 2) / 5 + 1);
+    m = (int)(mp < 10 ? mp + 3 : mp - 9);
+    y = (int)(yoe + era * 400 + (m <= 2));
+}
+
+// YYYY-MM-DD as days since 1970-01-01; false if malformed.
+inline bool parse_export_date(const std::string& text, int64_t& days) {
+    int y, m, d;
+    char tail;
+    if (sscanf(text.c_str(), "%d-%d-%d%c", &y, &m, &d, &tail) != 3 || m < 1 || m > 12 || d < 1 || d > 31) return false;
+    days = days_from_civil(y, m, d);
+    return true;
+}
+
+// Comma-separated list of csv, json, ics and all; false, leaving options
+// alone, on anything else.
+inline bool parse_export_formats(const std::string& text, ExportOptions& options) {
+    bool csv = false, json = false, ics = false;
+    std::stringstream list(text);
+    std::string format;
+    while (getline(list, format, ',')) {
+        if (format == "csv") csv = true;
+        else if (format == "json") json = true;
+        else if (format == "ics") ics = true;
+        else if (format == "all") csv = json = ics = true;
+        else return false;
+    }
+    if (!csv && !json && !ics) return false;
+    options.csv = csv;
+    options.json = json;
+    options.ics = ics;
+    return true;
+}
+
+// Appends to a string and writes it out in large blocks.
+class ExportWriter {
+public:
+    ExportWriter() = default;
+    ExportWriter(const ExportWriter&) = delete;
+    ExportWriter& operator=(const ExportWriter&) = delete;
+    ~ExportWriter() { close(); }
+
+    bool open(const std::string& path) {
+        file = fopen(path.c_str(), "wb");
+        ok = file != nullptr;
+        buffer.reserve(BLOCK * 2);
+        return ok;
+    }
+    ExportWriter& operator<<(std::string_view s) {
+        buffer.append(s);
+        if (buffer.size() >= BLOCK) flush();
+        return *this;
+    }
+    ExportWriter& operator<<(char c) {
+        buffer.push_back(c);
+        return *this;
+    }
+    ExportWriter& operator<<(int64_t v) {
+        char digits[24];
+        return *this << std::string_view(digits, snprintf(digits, sizeof digits, "%lld", (long long)v));
+    }
+    // False if the file could not be opened or written.
+    bool close() {
+        if (!file) return ok;
+        flush();
+        ok = fclose(file) == 0 && ok;
+        file = nullptr;
+        return ok;
+    }
+
+private:
+    static const size_t BLOCK = 1 << 16;
+    FILE* file = nullptr;
+    std::string buffer;
+    bool ok = false;
+
+    void flush() {
+        if (file && !buffer.empty()) ok = fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size() && ok;
+        buffer.clear();
+    }
+};
+
+namespace export_detail {
+
+inline void csv_field(ExportWriter& out, std::string_view s) {
+    if (s.find_first_of(",\"\r\n") == std::string_view::npos) {
+        out << s;
+        return;
+    }
+    out << '"';
+    for (char c : s) {
+        if (c == '"') out << '"';
+        out << c;
+    }
+    out << '"';
+}
+
+inline void json_string(ExportWriter& out, std::string_view s) {
+    out << '"';
+    for (char c : s) {
+        if (c == '"' || c == '\\') out << '\\' << c;
+        else if ((unsigned char)c < 0x20) {
+            char escaped[8];
+            out << std::string_view(escaped, snprintf(escaped, sizeof escaped, "\\u%04x", c));
+        }
+        else out << c;
+    }
+    out << '"';
+}
+
+inline std::string ics_text(std::string_view s) {
+    std::string text;
+    for (char c : s) {
+        if (c == '\\' || c == ';' || c == ',') text += '\\';
+        if (c == '\n') text += "\\n";
+        else if (c != '\r') text += c;
+    }
+    return text;
+}
+
+// One content line, folded at 75 octets as RFC 5545 asks.
+inline void ics_line(ExportWriter& out, std::string_view line) {
+    while (line.size() > 75) {
+        size_t cut = 75;
+        while (cut > 1 && ((unsigned char)line[cut] & 0xC0) == 0x80) --cut;  // keep UTF-8 sequences whole
+        out << line.substr(0, cut) << "\r\n ";
+        line.remove_prefix(cut);
+    }
+    out << line << "\r\n";
+}
+
+// Weekday of a day name (0 = Sunday), -1 if unknown.
+inline int weekday(std::string_view day) {
+    static const char* names[7] = { "sun", "mon", "tue", "wed", "thu", "fri", "sat" };
+    if (day.size() < 3) return -1;
+    for (int w = 0; w < 7; ++w) {
+        if (strncasecmp(day.data(), names[w], 3) == 0) return w;
+    }
+    return -1;
+}
+
+// Minutes after midnight of "9:00", "09:00:00 AM" or "2:15 pm"; -1 if unreadable.
+inline int minutes(std::string_view time) {
+    int h = 0, m = 0, i = 0, n = (int)time.size();
+    while (i < n && time[i] == ' ') ++i;
+    int start = i;
+    while (i < n && isdigit((unsigned char)time[i])) h = h * 10 + (time[i++] - '0');
+    if (i == start || i >= n || time[i] != ':') return -1;
+    start = ++i;
+    while (i < n && isdigit((unsigned char)time[i])) m = m * 10 + (time[i++] - '0');
+    if (i == start || h > 23 || m > 59) return -1;
+    if (i < n && time[i] == ':') {
+        ++i;
+        while (i < n && isdigit((unsigned char)time[i])) ++i;
+    }
+    while (i < n && time[i] == ' ') ++i;
+    if (i < n && (time[i] == 'P' || time[i] == 'p') && h < 12) h += 12;
+    else if (i < n && (time[i] == 'A' || time[i] == 'a') && h == 12) h = 0;
+    return h * 60 + m;
+}
+
+// One view: sessions ordered by key, then by timeslot. Each session row also
+// names the other two of section, teacher and room.
+struct View {
+    const char* name;     // file stem and JSON key
+    const char* keyName;  // what a key is
+    const std::vector<std::string>* keys;
+    const char* otherNames[2];
+    const std::vector<std::string>* otherKeys[2];
+    int ExportSession::* otherFields[2];
+    std::vector<int> order;  // sessions
+    std::vector<int> start;  // key -> first entry in order, plus an end marker
+};
+
+// With expand_shared, a session keyed by a shared label is listed under each
+// of its sections instead.
+inline void sort_view(const TimetableExport& t, View& view, int ExportSession::* field, bool expand_shared = false) {
+    int first_label = expand_shared ? (int)(t.sections.size() - t.sharedSections.size()) : INT_MAX;
+    auto for_keys = [&](const ExportSession& s, auto visit) {
+        if (s.*field < first_label) visit(s.*field);
+        else for (int key : t.sharedSections[s.*field - first_label]) visit(key);
+    };
+    // counting sort by timeslot, then a stable one by key
+    std::vector<int> by_slot(t.slots.size() + 1, 0);
+    for (const auto& s : t.sessions) ++by_slot[s.slot + 1];
+    for (size_t i = 1; i < by_slot.size(); ++i) by_slot[i] += by_slot[i - 1];
+    std::vector<int> slot_order(t.sessions.size());
+    for (int i = 0; i < (int)t.sessions.size(); ++i) slot_order[by_slot[t.sessions[i].slot]++] = i;
+    view.start.assign(view.keys->size() + 1, 0);
+    for (const auto& s : t.sessions) for_keys(s, [&](int key) { ++view.start[key + 1]; });
+    for (size_t k = 1; k < view.start.size(); ++k) view.start[k] += view.start[k - 1];
+    std::vector<int> fill(view.start.begin(), view.start.end() - 1);
+    view.order.resize(view.start.back());
+    for (int i : slot_order) for_keys(t.sessions[i], [&](int key) { view.order[fill[key]++] = i; });
+}
+
+inline bool write_csv(const TimetableExport& t, const View& view, const std::string& path) {
+    ExportWriter out;
+    if (!out.open(path)) return false;
+    bool teachers = view.keys == &t.teachers;
+    out << view.keyName << (teachers ? ",role" : "") << ",day,start,end,slot,course,type";
+    for (const char* other : view.otherNames) out << ',' << other;
+    out << '\n';
+    for (size_t k = 0; k + 1 < view.start.size(); ++k) {
+        for (int e = view.start[k]; e < view.start[k + 1]; ++e) {
+            const ExportSession& s = t.sessions[view.order[e]];
+            const ExportSlot& slot = t.slots[s.slot];
+            csv_field(out, (*view.keys)[k]);
+            if (teachers) csv_field(out << ',', t.teacherRoles[k]);
+            csv_field(out << ',', slot.day);
+            csv_field(out << ',', slot.start);
+            csv_field(out << ',', slot.end);
+            csv_field(out << ',', slot.id);
+            csv_field(out << ',', t.courses[s.course]);
+            csv_field(out << ',', s.type);
+            for (int o = 0; o < 2; ++o) csv_field(out << ',', (*view.otherKeys[o])[s.*view.otherFields[o]]);
+            out << '\n';
+        }
+    }
+    return out.close();
+}
+
+inline bool write_json(const TimetableExport& t, const View& view, const std::string& path) {
+    ExportWriter out;
+    if (!out.open(path)) return false;
+    bool teachers = view.keys == &t.teachers;
+    out << "{\"view\": \"" << view.name << "\", \"" << view.name << "\": [";
+    bool first_key = true;
+    for (size_t k = 0; k + 1 < view.start.size(); ++k) {
+        if (view.start[k] == view.start[k + 1]) continue;
+        out << (first_key ? "\n  {\"name\": " : ",\n  {\"name\": ");
+        first_key = false;
+        json_string(out, (*view.keys)[k]);
+        if (teachers) json_string(out << ", \"role\": ", t.teacherRoles[k]);
+        out << ", \"sessions\": [";
+        for (int e = view.start[k]; e < view.start[k + 1]; ++e) {
+            const ExportSession& s = t.sessions[view.order[e]];
+            const ExportSlot& slot = t.slots[s.slot];
+            out << (e == view.start[k] ? "\n    {\"day\": " : ",\n    {\"day\": ");
+            json_string(out, slot.day);
+            json_string(out << ", \"start\": ", slot.start);
+            json_string(out << ", \"end\": ", slot.end);
+            json_string(out << ", \"slot\": ", slot.id);
+            json_string(out << ", \"course\": ", t.courses[s.course]);
+            json_string(out << ", \"type\": ", s.type);
+            for (int o = 0; o < 2; ++o) {
+                out << ", \"" << view.otherNames[o] << "\": ";
+                json_string(out, (*view.otherKeys[o])[s.*view.otherFields[o]]);
+            }
+            out << '}';
+        }
+        out << "]}";
+    }
+    out << "\n]}\n";
+    return out.close();
+}
+
+// Weekly events from the first matching day on or after weekStart. Sessions
+// whose day or times cannot be read are left out and counted in skipped.
+inline bool write_ics(const TimetableExport& t, const View& view, const std::string& path, int64_t week_start, size_t& skipped) {
+    ExportWriter out;
+    if (!out.open(path)) return false;
+    std::vector<int64_t> slot_day(t.slots.size());
+    std::vector<int> slot_start(t.slots.size()), slot_end(t.slots.size());
+    int first_weekday = (int)(((week_start + 4) % 7 + 7) % 7);  // 1970-01-01 was a Thursday
+    for (size_t i = 0; i < t.slots.size(); ++i) {
+        int w = weekday(t.slots[i].day);
+        slot_day[i] = w < 0 ? -1 : week_start + (w - first_weekday + 7) % 7;
+        slot_start[i] = minutes(t.slots[i].start);
+        slot_end[i] = minutes(t.slots[i].end);
+    }
+    char stamp[32];
+    time_t now = time(nullptr);
+    strftime(stamp, sizeof stamp, "%Y%m%dT%H%M%SZ", gmtime(&now));
+
+    ics_line(out, "BEGIN:VCALENDAR");
+    ics_line(out, "VERSION:2.0");
+    ics_line(out, "PRODID:-//timetable scheduler//export//EN");
+    ics_line(out, "X-WR-CALNAME:Timetable by " + std::string(view.keyName));
+    std::string line;
+    char when[64];
+    for (size_t k = 0; k + 1 < view.start.size(); ++k) {
+        for (int e = view.start[k]; e < view.start[k + 1]; ++e) {
+            const ExportSession& s = t.sessions[view.order[e]];
+            if (slot_day[s.slot] < 0 || slot_start[s.slot] < 0 || slot_end[s.slot] < 0) {
+                ++skipped;
+                continue;
+            }
+            int y, m, d;
+            civil_from_days(slot_day[s.slot], y, m, d);
+            ics_line(out, "BEGIN:VEVENT");
+            line = "UID:";
+            line += view.name;
+            line += '-';
+            line += std::to_string(view.order[e]);
+            if (view.keys == &t.sections && s.section != (int)k) {
+                // a shared session is listed once per section
+                line += '-';
+                line += std::to_string(k);
+            }
+            line += "@timetable";
+            ics_line(out, line);
+            ics_line(out, std::string("DTSTAMP:") + stamp);
+            snprintf(when, sizeof when, "DTSTART:%04d%02d%02dT%02d%02d00", y, m, d, slot_start[s.slot] / 60, slot_start[s.slot] % 60);
+            ics_line(out, when);
+            snprintf(when, sizeof when, "DTEND:%04d%02d%02dT%02d%02d00", y, m, d, slot_end[s.slot] / 60, slot_end[s.slot] % 60);
+            ics_line(out, when);
+            ics_line(out, "RRULE:FREQ=WEEKLY");
+            line = "SUMMARY:" + ics_text(t.courses[s.course]) + ' ' + ics_text(s.type);
+            ics_line(out, line);
+            line = "LOCATION:" + ics_text(t.rooms[s.room]);
+            ics_line(out, line);
+            line = "DESCRIPTION:" + ics_text("Section: " + t.sections[s.section] + "\nTeacher: " + t.teachers[s.teacher]);
+            ics_line(out, line);
+            line = "CATEGORIES:" + ics_text((*view.keys)[k]);
+            ics_line(out, line);
+            ics_line(out, "END:VEVENT");
+        }
+    }
+    ics_line(out, "END:VCALENDAR");
+    return out.close();
+}
+
+} // namespace export_detail
+
+// Writes sections, teachers and rooms views into dir (created if missing) in
+// the formats options selects. skipped counts sessions left out of the .ics
+// files. False if some file could not be written.
+inline bool write_exports(const TimetableExport& t, const std::string& dir, const ExportOptions& options, size_t& skipped) {
+    using namespace export_detail;
+    mkdir(dir.c_str(), 0755);
+    View views[3] = {
+        { "sections", "section", &t.sections, { "teacher", "room" }, { &t.teachers, &t.rooms },
+            { &ExportSession::teacher, &ExportSession::room }, {}, {} },
+        { "teachers", "teacher", &t.teachers, { "section", "room" }, { &t.sections, &t.rooms },
+            { &ExportSession::section, &ExportSession::room }, {}, {} },
+        { "rooms", "room", &t.rooms, { "section", "teacher" }, { &t.sections, &t.teachers },
+            { &ExportSession::section, &ExportSession::teacher }, {}, {} },
+    };
+    sort_view(t, views[0], &ExportSession::section, true);
+    sort_view(t, views[1], &ExportSession::teacher);
+    sort_view(t, views[2], &ExportSession::room);
+    bool ok = true;
+    skipped = 0;
+    for (const View& view : views) {
+        std::string stem = dir + "/" + view.name;
+        if (options.csv) ok = write_csv(t, view, stem + ".csv") && ok;
+        if (options.json) ok = write_json(t, view, stem + ".json") && ok;
+        if (options.ics) ok = write_ics(t, view, stem + ".ics", options.weekStart, skipped) && ok;
+    }
+    return ok;
+}
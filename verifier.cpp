@@ -0,0 +1,528 @@
+// verifier.cpp
+// Standalone checker for timetables exported by ConsoleApplication1 (--export),
+// including hand-edited ones. It reads the teachers.csv or rooms.csv view (one
+// row per session; sections.csv repeats a shared lecture under each section
+// and is rejected) and the input tables the timetable was built from, checks
+// every hard constraint in one pass over the rows, and scores the soft
+// constraints the way --optimize does.
+// Build: g++ -std=c++17 -O2 verifier.cpp -o verifier
+// Run:   ./verifier [--tables DIR] [--xlsx] [--report FILE|-] [--max-listed N] EXPORT
+// EXPORT is an export directory (its teachers.csv is read) or a view's CSV.
+// Hard constraints: no room, section or teacher holds two sessions in one
+// timeslot; rooms seat the sections and have a type the room rules allow;
+// lectures go to qualified instructors and tutorials and labs to TAs with the
+// role; every section gets each session its courses call for, no more; every
+// name and timeslot exists. Occupancy is one hash table keyed by (resource,
+// timeslot). The report is JSON: counts per violation kind, the soft cost and
+// its parts, and the first --max-listed violations.
+// Exit status: 0 when every hard constraint holds, 1 when some do not, 2 when
+// the input cannot be read.
+
+#include <bits/stdc++.h>
+#include <sys/stat.h>
+#include "csv_reader.h"
+#include "xlsx_reader.h"
+#include "room_rules.h"
+#include "soft_weights.h"
+
+using namespace std;
+
+enum SessionType : uint8_t { LECTURE, TUTORIAL, LAB };
+enum : uint8_t { ROLE_TUT = 1, ROLE_LAB = 2 };
+
+struct TimeSlot {
+    int id;
+    string day, startTime, endTime;
+};
+
+struct Room {
+    string id;
+    int capacity;
+    string type;
+};
+
+struct Teacher {
+    string name;
+    string preferredSlots;
+    bool instructor;
+    unordered_map<int, uint8_t> courses;  // course -> ROLE_* bits; instructors use ROLE_TUT | ROLE_LAB
+};
+
+struct Section {
+    string faculty, dept;
+    int year, groupNumber, sectionNumber, studentNumber;
+};
+
+struct Course {
+    int year;
+    string specialization;
+    int code;
+    int slots[3];  // lectures, tutorials, labs
+};
+
+vector<TimeSlot> timeSlots;
+vector<Room> rooms;
+vector<Teacher> teachers;  // instructors, then TAs
+vector<Section> sections;
+vector<Course> courses;
+unordered_map<string, int> courseIds, roomIds, slotIds, sectionIds, teacherIds[2];  // teacherIds[1] for instructors
+vector<string> courseNames, sectionNames;
+RoomRules roomRules;
+
+string trim(string_view s) {
+    size_t first = s.find_first_not_of(" \t");
+    if (first == string_view::npos) return "";
+    size_t last = s.find_last_not_of(" \t");
+    return string(s.substr(first, last - first + 1));
+}
+
+int to_int(string_view cell) {
+    int value = 0;
+    auto [end, ec] = from_chars(cell.data(), cell.data() + cell.size(), value);
+    if (ec != errc() || end != cell.data() + cell.size()) throw invalid_argument("not an integer: " + string(cell));
+    return value;
+}
+
+int intern_course(const string& code) {
+    auto it = courseIds.emplace(code, (int)courseNames.size()).first;
+    if (it->second == (int)courseNames.size()) courseNames.push_back(code);
+    return it->second;
+}
+
+unique_ptr<CsvTable> read_table(const string& path, bool xlsx) {
+    if (!xlsx) {
+        auto csv = make_unique<CsvFile>();
+        if (csv->open(path + ".csv")) return csv;
+    }
+    auto book = make_unique<XlsxFile>();
+    if (book->open(path + ".xlsx")) return book;
+    return nullptr;
+}
+
+// The input tables, read as ConsoleApplication1 reads them.
+bool load_tables(const string& dir, bool xlsx) {
+    auto table = [&](const char* name) {
+        auto t = read_table(dir + "/" + name, xlsx);
+        if (!t) cerr << "Cannot read " << dir << "/" << name << (xlsx ? ".xlsx" : ".csv") << endl;
+        return t;
+    };
+    auto slots = table("TimeSlots"), halls = table("Halls"), instructors = table("Instructor"), tas = table("TAs"),
+        secs = table("Sections"), crs = table("Courses");
+    if (!slots || !halls || !instructors || !tas || !secs || !crs) return false;
+
+    for (size_t i = 1; i < slots->rows(); ++i) {
+        CsvRow row = (*slots)[i];
+        if (row.size() < 4) continue;
+        timeSlots.push_back({ to_int(row[3]), string(row[0]), string(row[1]), string(row[2]) });
+        slotIds.emplace(to_string(timeSlots.back().id), (int)timeSlots.size() - 1);
+    }
+    string building;
+    for (size_t i = 1; i < halls->rows(); ++i) {
+        CsvRow row = (*halls)[i];
+        if (row.size() < 4) continue;
+        if (!row[0].empty()) building = row[0];
+        if (row[1].empty()) continue;
+        string id = trim(building + " " + string(row[1]));
+        if (!roomIds.emplace(id, (int)rooms.size()).second) {
+            cerr << "Halls row " << i + 1 << ": " << id << " repeats an earlier room and is skipped" << endl;
+            continue;
+        }
+        rooms.push_back({ id, to_int(row[2]), trim(row[3]) });
+    }
+    for (size_t i = 1; i < instructors->rows(); ++i) {
+        CsvRow row = (*instructors)[i];
+        if (row.size() < 4) continue;
+        Teacher t{ string(row[1]), string(row[2]), true, {} };
+        stringstream ss{ string(row[3]) };
+        string course;
+        while (getline(ss, course, ',')) t.courses[intern_course(trim(course))] = ROLE_TUT | ROLE_LAB;
+        teacherIds[1].emplace(t.name, (int)teachers.size());
+        teachers.push_back(move(t));
+    }
+    for (size_t i = 1; i < tas->rows(); ++i) {
+        CsvRow row = (*tas)[i];
+        if (row.size() < 4) continue;
+        Teacher t{ string(row[1]), string(row[2]), false, {} };
+        // "PHY 113 (TUT + LAB), CNC 111 (LAB)"
+        stringstream ss{ string(row[3]) };
+        string token;
+        while (getline(ss, token, ',')) {
+            size_t open = token.find('('), close = token.rfind(')');
+            if (open == string::npos) continue;
+            string role = token.substr(open + 1, close - open - 1);
+            uint8_t roles = (role.find("TUT") != string::npos ? ROLE_TUT : 0) | (role.find("LAB") != string::npos ? ROLE_LAB : 0);
+            t.courses[intern_course(trim(token.substr(0, open)))] = roles;
+        }
+        teacherIds[0].emplace(t.name, (int)teachers.size());
+        teachers.push_back(move(t));
+    }
+    string faculty, dept;
+    int year = 0, group = 0;
+    for (size_t i = 1; i < secs->rows(); ++i) {
+        CsvRow row = (*secs)[i];
+        if (row.size() < 6) continue;
+        if (!row[0].empty()) faculty = row[0];
+        if (!row[1].empty()) year = to_int(row[1]);
+        if (!row[2].empty()) dept = row[2];
+        if (!row[3].empty()) group = to_int(row[3]);
+        if (row[4].empty() || row[5].empty()) continue;
+        Section s{ faculty, dept, year, group, to_int(row[4]), to_int(row[5]) };
+        // the section's name in the export
+        string name = s.faculty + " Y" + to_string(s.year) + (s.dept != "N/A" ? " " + s.dept : "") + " G" + to_string(s.groupNumber) + " S" + to_string(s.sectionNumber);
+        sectionIds.emplace(name, (int)sections.size());
+        sectionNames.push_back(name);
+        sections.push_back(s);
+    }
+    int course_year = 0;
+    string spec;
+    for (size_t i = 1; i < crs->rows(); ++i) {
+        CsvRow row = (*crs)[i];
+        if (row.size() < 8) continue;
+        if (!row[0].empty()) course_year = to_int(row[0]);
+        if (!row[2].empty()) spec = row[2];
+        if (row[3].empty()) continue;
+        courses.push_back({ course_year, spec, intern_course(string(row[3])), { to_int(row[5]), to_int(row[6]), to_int(row[7]) } });
+    }
+
+    // ConsoleApplication1's built-in room rules, unless RoomRules replaces them
+    roomRules.rules = timetable_room_rules();
+    string error;
+    if (auto rules = read_table(dir + "/RoomRules", xlsx); rules && !roomRules.load(*rules, error)) {
+        cerr << "RoomRules " << error << endl;
+        return false;
+    }
+    vector<string> types;
+    for (const auto& room : rooms) types.push_back(room.type);
+    if (!roomRules.compile(courseNames, types)) {
+        cerr << "RoomRules: more than 64 distinct room classes" << endl;
+        return false;
+    }
+    return true;
+}
+
+// Every kind of hard violation, in report order.
+enum ViolationKind { V_UNKNOWN, V_SLOT_MISMATCH, V_ROOM_CLASH, V_SECTION_CLASH, V_TEACHER_CLASH, V_CAPACITY, V_ROOM_TYPE,
+    V_QUALIFICATION, V_MISSING, V_EXTRA, V_KINDS };
+const char* KIND_NAMES[V_KINDS] = { "unknown_name", "slot_mismatch", "room_clash", "section_clash", "teacher_clash", "capacity",
+    "room_type", "qualification", "missing_session", "extra_session" };
+
+struct Violation {
+    ViolationKind kind;
+    size_t line;  // line in the timetable CSV, 0 for a section's totals
+    string detail;
+};
+
+struct Report {
+    size_t sessions = 0;
+    size_t counts[V_KINDS] = {};
+    vector<Violation> listed;
+    size_t maxListed = 50;
+    long long preference = 0, gaps = 0, waste = 0, load = 0;
+
+    // detail() builds the text only for violations that get listed
+    template <class Detail> void add(ViolationKind kind, size_t line, Detail detail) {
+        ++counts[kind];
+        if (listed.size() < maxListed) listed.push_back({ kind, line, detail() });
+    }
+    size_t hard() const { return accumulate(begin(counts), end(counts), size_t(0)); }
+    long long soft() const { return preference + gaps + waste + load; }
+};
+
+// Open-addressing set of (resource kind, resource, timeslot) keys, each
+// remembering the first line that took it.
+class Occupancy {
+public:
+    explicit Occupancy(size_t expected) {
+        size_t size = 16;
+        while (size < 2 * expected) size <<= 1;
+        keys.assign(size, EMPTY);
+        lines.resize(size);
+        mask = size - 1;
+    }
+
+    // 0 if the key was free (and now holds line), else the line holding it.
+    size_t take(int kind, int resource, int slot, size_t line) {
+        uint64_t key = ((uint64_t)(uint32_t)resource << 32 | (uint32_t)slot << 2) | (uint64_t)kind;
+        size_t h = (size_t)(key * 0x9E3779B97F4A7C15ull >> 17) & mask;
+        while (keys[h] != EMPTY) {
+            if (keys[h] == key) return lines[h];
+            h = (h + 1) & mask;
+        }
+        keys[h] = key;
+        lines[h] = line;
+        return 0;
+    }
+
+private:
+    static constexpr uint64_t EMPTY = UINT64_MAX;
+    vector<uint64_t> keys;
+    vector<size_t> lines;
+    size_t mask;
+};
+
+// Sections named by an export label: one section, or "<first> S1+2+3" for a
+// lecture shared by several sections of a group. Empty if a name is unknown.
+vector<int> label_sections(const string& label) {
+    vector<int> result;
+    size_t plus = label.find('+');
+    auto first = sectionIds.find(label.substr(0, plus));
+    if (first == sectionIds.end()) return {};
+    result.push_back(first->second);
+    if (plus == string::npos) return result;
+    string prefix = label.substr(0, label.rfind(" S", plus) + 2);
+    while (plus != string::npos) {
+        size_t next = label.find('+', plus + 1);
+        auto it = sectionIds.find(prefix + label.substr(plus + 1, next == string::npos ? string::npos : next - plus - 1));
+        if (it == sectionIds.end()) return {};
+        result.push_back(it->second);
+        plus = next;
+    }
+    return result;
+}
+
+// Slot ids or day names separated by commas, semicolons or spaces, as
+// ConsoleApplication1 reads PreferredSlots; empty when there is no preference.
+vector<uint8_t> preferred_slots(string text) {
+    vector<uint8_t> preferred;
+    replace(text.begin(), text.end(), ',', ' ');
+    replace(text.begin(), text.end(), ';', ' ');
+    stringstream ss(text);
+    string token;
+    while (ss >> token) {
+        if (token == "N/A") continue;
+        for_slot_token(timeSlots, token, [&](int t) {
+            preferred.resize(timeSlots.size());
+            preferred[t] = 1;
+        });
+    }
+    return preferred;
+}
+
+bool verify(const CsvTable& table, Report& report) {
+    if (table.empty()) return false;
+    // columns by header name, so either view reads
+    map<string, int> col;
+    CsvRow header = table[0];
+    for (size_t c = 0; c < header.size(); ++c) col[string(header[c])] = (int)c;
+    // a view's first column is its key; the sections view repeats a shared
+    // lecture under each of its sections
+    if (header.size() > 0 && header[0] == "section") {
+        cerr << "Timetable is the sections view; give its teachers.csv or rooms.csv" << endl;
+        return false;
+    }
+    for (const char* need : { "section", "teacher", "room", "slot", "course", "type" }) {
+        if (!col.count(need)) {
+            cerr << "Timetable has no " << need << " column" << endl;
+            return false;
+        }
+    }
+    int c_section = col["section"], c_teacher = col["teacher"], c_room = col["room"], c_slot = col["slot"], c_course = col["course"],
+        c_type = col["type"];
+    int c_role = col.count("role") ? col["role"] : -1, c_day = col.count("day") ? col["day"] : -1,
+        c_start = col.count("start") ? col["start"] : -1, c_end = col.count("end") ? col["end"] : -1;
+
+    // soft model: day index and position within the day of every slot
+    map<string, int> day_of;
+    vector<int> slot_day, slot_position, next_position;
+    for (const auto& ts : timeSlots) {
+        auto it = day_of.emplace(ts.day, (int)day_of.size()).first;
+        if (it->second == (int)next_position.size()) next_position.push_back(0);
+        slot_day.push_back(it->second);
+        slot_position.push_back(min(next_position[it->second]++, 63));
+    }
+    size_t days = day_of.size();
+    vector<vector<uint8_t>> preferred;
+    for (const auto& t : teachers) preferred.push_back(preferred_slots(t.preferredSlots));
+    vector<uint64_t> section_days(sections.size() * days, 0);
+    vector<int> teacher_load(teachers.size() * days, 0);
+
+    unordered_map<string, vector<int>> labels;
+    map<uint64_t, int> attended;  // (section, course, type) -> sessions, ordered for a stable report
+    Occupancy occupancy(table.rows() * 4);
+    enum { ROOM, SECTION, TEACHER };
+    for (size_t i = 1; i < table.rows(); ++i) {
+        CsvRow row = table[i];
+        if (row.size() == 0 || (row.size() == 1 && row[0].empty())) continue;
+        ++report.sessions;
+        size_t line = i + 1;
+        string type_name(row[c_type]);
+        int type = type_name == "Lecture" ? LECTURE : type_name == "Tutorial" ? TUTORIAL : type_name == "Lab" ? LAB : -1;
+        auto slot_it = slotIds.find(string(row[c_slot]));
+        auto room_it = roomIds.find(string(row[c_room]));
+        auto course_it = courseIds.find(string(row[c_course]));
+        // the role column decides between instructor and TA; without it the session type does
+        bool instructor = c_role >= 0 ? row[c_role] == "Instructor" : type == LECTURE;
+        auto teacher_it = teacherIds[instructor].find(string(row[c_teacher]));
+        auto label_it = labels.find(string(row[c_section]));
+        if (label_it == labels.end()) label_it = labels.emplace(string(row[c_section]), label_sections(string(row[c_section]))).first;
+        const vector<int>& secs = label_it->second;
+        string unknown;
+        if (type < 0) unknown += " type '" + type_name + "'";
+        if (slot_it == slotIds.end()) unknown += " slot '" + string(row[c_slot]) + "'";
+        if (room_it == roomIds.end()) unknown += " room '" + string(row[c_room]) + "'";
+        if (course_it == courseIds.end()) unknown += " course '" + string(row[c_course]) + "'";
+        if (teacher_it == teacherIds[instructor].end()) unknown += string(instructor ? " instructor '" : " TA '") + string(row[c_teacher]) + "'";
+        if (secs.empty()) unknown += " section '" + string(row[c_section]) + "'";
+        if (!unknown.empty()) {
+            report.add(V_UNKNOWN, line, [&] { return "unknown" + unknown; });
+            continue;
+        }
+        int slot = slot_it->second, room = room_it->second, course = course_it->second, teacher = teacher_it->second;
+        const TimeSlot& ts = timeSlots[slot];
+        if ((c_day >= 0 && row[c_day] != ts.day) || (c_start >= 0 && row[c_start] != ts.startTime) || (c_end >= 0 && row[c_end] != ts.endTime)) {
+            report.add(V_SLOT_MISMATCH, line, [&] { return "day or times differ from slot " + to_string(ts.id); });
+        }
+
+        auto where = [&] { return " at slot " + to_string(ts.id); };
+        if (size_t other = occupancy.take(ROOM, room, slot, line)) report.add(V_ROOM_CLASH, line, [&] { return rooms[room].id + where() + " also on line " + to_string(other); });
+        if (size_t other = occupancy.take(TEACHER, teacher, slot, line)) report.add(V_TEACHER_CLASH, line, [&] { return teachers[teacher].name + where() + " also on line " + to_string(other); });
+        int students = 0;
+        for (int sec : secs) {
+            students += sections[sec].studentNumber;
+            if (size_t other = occupancy.take(SECTION, sec, slot, line)) report.add(V_SECTION_CLASH, line, [&] { return sectionNames[sec] + where() + " also on line " + to_string(other); });
+            ++attended[((uint64_t)sec * courseNames.size() + course) * 3 + type];
+        }
+
+        const RoomClass& rc = roomRules.session_class(course, type);
+        if (!(roomRules.room_bit(room) & rc.rooms)) report.add(V_ROOM_TYPE, line, [&] { return rooms[room].id + " (" + rooms[room].type + ") for a " + type_name; });
+        if (rooms[room].capacity < max(students, rc.minCapacity)) {
+            report.add(V_CAPACITY, line, [&] { return rooms[room].id + " seats " + to_string(rooms[room].capacity) + " for " + to_string(students) + " students"; });
+        }
+        const Teacher& t = teachers[teacher];
+        auto qual = t.courses.find(course);
+        bool qualified = type == LECTURE ? t.instructor && qual != t.courses.end()
+            : !t.instructor && qual != t.courses.end() && (qual->second & (type == TUTORIAL ? ROLE_TUT : ROLE_LAB));
+        if (!qualified) report.add(V_QUALIFICATION, line, [&] { return t.name + " is not qualified for " + courseNames[course] + " " + type_name; });
+
+        // soft cost
+        report.waste += (long long)WASTE_WEIGHT * (rooms[room].capacity - students);
+        if (!preferred[teacher].empty() && !preferred[teacher][slot]) report.preference += PREFERENCE_WEIGHT;
+        int& load = teacher_load[(size_t)teacher * days + slot_day[slot]];
+        if (++load > MAX_DAILY_LOAD) report.load += LOAD_WEIGHT;
+        for (int sec : secs) section_days[(size_t)sec * days + slot_day[slot]] |= uint64_t(1) << slot_position[slot];
+    }
+    for (uint64_t mask : section_days) {
+        if (!mask) continue;
+        int span = 64 - __builtin_clzll(mask) - __builtin_ctzll(mask);
+        report.gaps += (long long)GAP_WEIGHT * (span - __builtin_popcountll(mask));
+    }
+
+    // each section's sessions against what its courses call for
+    static const char* TYPE_NAMES[3] = { "Lecture", "Tutorial", "Lab" };
+    map<uint64_t, int> demand;
+    for (const auto& c : courses) {
+        for (int sec = 0; sec < (int)sections.size(); ++sec) {
+            const Section& s = sections[sec];
+            if (s.year != c.year || !(c.specialization == "N/A" || s.dept.empty() || s.dept == c.specialization)) continue;
+            for (int type = 0; type < 3; ++type) {
+                if (c.slots[type]) demand[((uint64_t)sec * courseNames.size() + c.code) * 3 + type] += c.slots[type];
+            }
+        }
+    }
+    auto describe = [&](uint64_t key, int have, int want) {
+        int type = key % 3, course = key / 3 % courseNames.size(), sec = key / 3 / courseNames.size();
+        return sectionNames[sec] + " has " + to_string(have) + " of " + to_string(want) + " " + courseNames[course] + " " + TYPE_NAMES[type];
+    };
+    for (const auto& [key, want] : demand) {
+        auto it = attended.find(key);
+        int have = it == attended.end() ? 0 : it->second;
+        if (have < want) report.add(V_MISSING, 0, [&] { return describe(key, have, want); });
+    }
+    for (const auto& [key, have] : attended) {
+        auto it = demand.find(key);
+        int want = it == demand.end() ? 0 : it->second;
+        if (have > want) report.add(V_EXTRA, 0, [&] { return describe(key, have, want); });
+    }
+    return true;
+}
+
+void json_string(ostream& out, const string& s) {
+    out << '"';
+    for (char c : s) {
+        if (c == '"' || c == '\\') out << '\\' << c;
+        else if ((unsigned char)c < 0x20) out << "\\u" << hex << setw(4) << setfill('0') << (int)c << dec << setfill(' ');
+        else out << c;
+    }
+    out << '"';
+}
+
+// JSON report for --report; path "-" writes to stderr.
+bool write_report(const string& path, const string& timetable, const Report& report, double ms) {
+    ofstream file;
+    if (path != "-") file.open(path);
+    ostream& out = path == "-" ? cerr : file;
+    out << "{\n  \"timetable\": ";
+    json_string(out, timetable);
+    out << ",\n  \"sessions\": " << report.sessions << ",\n  \"valid\": " << (report.hard() ? "false" : "true")
+        << ",\n  \"hard\": {\"total\": " << report.hard();
+    for (int k = 0; k < V_KINDS; ++k) out << ", \"" << KIND_NAMES[k] << "\": " << report.counts[k];
+    out << "},\n  \"soft\": {\"cost\": " << report.soft() << ", \"preference\": " << report.preference << ", \"gaps\": " << report.gaps
+        << ", \"waste\": " << report.waste << ", \"load\": " << report.load << "},\n  \"verify_ms\": " << ms << ",\n  \"violations\": [";
+    for (size_t i = 0; i < report.listed.size(); ++i) {
+        const Violation& v = report.listed[i];
+        out << (i ? ",\n    " : "\n    ") << "{\"kind\": \"" << KIND_NAMES[v.kind] << "\", \"line\": " << v.line << ", \"detail\": ";
+        json_string(out, v.detail);
+        out << '}';
+    }
+    out << (report.listed.empty() ? "]\n}\n" : "\n  ]\n}\n");
+    return (bool)out;
+}
+
+void usage(const char* prog) {
+    fprintf(stderr, "Usage: %s [--tables DIR] [--xlsx] [--report FILE|-] [--max-listed N] EXPORT\n", prog);
+}
+
+int main(int argc, char** argv) {
+    string tables = ".", report_path, timetable;
+    bool xlsx = false;
+    Report report;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--tables" && i + 1 < argc) tables = argv[++i];
+        else if (arg == "--xlsx") xlsx = true;
+        else if (arg == "--report" && i + 1 < argc) report_path = argv[++i];
+        else if (arg == "--max-listed" && i + 1 < argc) report.maxListed = strtoull(argv[++i], nullptr, 10);
+        else if (timetable.empty() && arg[0] != '-') timetable = arg;
+        else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (timetable.empty()) {
+        usage(argv[0]);
+        return 2;
+    }
+    struct stat info;
+    if (stat(timetable.c_str(), &info) == 0 && S_ISDIR(info.st_mode)) timetable += "/teachers.csv";
+
+    auto start = chrono::steady_clock::now();
+    CsvFile file;
+    try {
+        if (!load_tables(tables, xlsx)) return 2;
+        if (!file.open(timetable)) {
+            cerr << "Cannot read " << timetable << endl;
+            return 2;
+        }
+        if (!verify(file, report)) return 2;
+    }
+    catch (const exception& e) {
+        cerr << "Malformed input table: " << e.what() << endl;
+        return 2;
+    }
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    cout << "Verified " << report.sessions << " sessions in " << fixed << setprecision(1) << ms << " ms: " << report.hard()
+         << " hard violations, soft cost " << report.soft() << '\n';
+    for (const auto& v : report.listed) {
+        cout << "  " << KIND_NAMES[v.kind];
+        if (v.line) cout << " line " << v.line;
+        cout << ": " << v.detail << '\n';
+    }
+    if (report.listed.size() < report.hard()) cout << "  ... " << report.hard() - report.listed.size() << " more" << '\n';
+    cout.flush();
+    if (!report_path.empty() && !write_report(report_path, timetable, report, ms)) {
+        cerr << "Could not write report: " << report_path << endl;
+        return 2;
+    }
+    return report.hard() ? 1 : 0;
+}
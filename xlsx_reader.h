@@ -0,0 +1,588 @@
+// xlsx_reader.h
+// Reads the first worksheet of an .xlsx workbook into a CsvTable, so the load
+// functions take workbooks and CSVs alike. The zip container is walked through
+// its central directory, and the first sheet's part is found through
+// xl/workbook.xml and its relationships. That part and xl/sharedStrings.xml
+// are inflated whole by the DEFLATE decoder below, not streamed: cell values
+// are kept in one buffer anyway, and a registrar table inflates to a few
+// megabytes at most. Both are scanned tag by tag without building a DOM.
+// Cells come out the way the CSV reader returns an
+// export of the sheet: shared strings resolved and trimmed, missing cells and
+// rows empty (a merged range keeps its value in the top-left cell only, which
+// the loaders forward-fill), and time-formatted numbers as "hh:mm:ss AM".
+#pragma once
+
+#include "csv_reader.h"
+
+// DEFLATE (RFC 1951) decoder: 9-bit lookup tables for the common short codes,
+// canonical bit-by-bit decoding for the rest.
+class Inflater {
+public:
+    // Appends the decoded form of src to out; false on corrupt input.
+    static bool inflate(const unsigned char* src, size_t len, std::string& out) {
+        Inflater state(src, len, out);
+        return state.run();
+    }
+
+private:
+    static constexpr int FAST_BITS = 9;
+
+    struct Huffman {
+        uint16_t fast[1 << FAST_BITS];  // (symbol << 4) | length, 0 for longer codes
+        short count[16];
+        short symbol[320];
+    };
+
+    const unsigned char* in;
+    size_t inLen;
+    size_t pos = 0;
+    uint64_t bitBuf = 0;
+    int bitCount = 0;
+    size_t overrun = 0;  // zero bytes fed past the end of the input
+    std::string& out;
+
+    Inflater(const unsigned char* src, size_t len, std::string& dst) : in(src), inLen(len), out(dst) {}
+
+    void refill() {
+        while (bitCount <= 56) {
+            uint64_t byte = 0;
+            if (pos < inLen) byte = in[pos++];
+            else ++overrun;
+            bitBuf |= byte << bitCount;
+            bitCount += 8;
+        }
+    }
+    int bits(int need) {
+        if (bitCount < need) refill();
+        int value = (int)(bitBuf & ((uint64_t(1) << need) - 1));
+        bitBuf >>= need;
+        bitCount -= need;
+        return value;
+    }
+    // True once a read used bytes that are not in the input.
+    bool exhausted() const { return overrun * 8 > (size_t)bitCount; }
+
+    // Canonical code from code lengths; false if over-subscribed.
+    static bool build(Huffman& h, const short* lengths, int n) {
+        memset(h.count, 0, sizeof h.count);
+        memset(h.fast, 0, sizeof h.fast);
+        for (int s = 0; s < n; ++s) ++h.count[lengths[s]];
+        int left = 1;
+        for (int len = 1; len < 16; ++len) {
+            left = (left << 1) - h.count[len];
+            if (left < 0) return false;
+        }
+        short offs[16] = {};
+        for (int len = 1; len < 15; ++len) offs[len + 1] = offs[len] + h.count[len];
+        int next_code[16] = {};
+        int code = 0;
+        h.count[0] = 0;
+        for (int len = 1; len < 16; ++len) {
+            code = (code + h.count[len - 1]) << 1;
+            next_code[len] = code;
+        }
+        for (int s = 0; s < n; ++s) {
+            int len = lengths[s];
+            if (!len) continue;
+            h.symbol[offs[len]++] = s;
+            int c = next_code[len]++;
+            if (len > FAST_BITS) continue;
+            int reversed = 0;
+            for (int b = 0; b < len; ++b) reversed |= ((c >> b) & 1) << (len - 1 - b);
+            for (int fill = reversed; fill < (1 << FAST_BITS); fill += 1 << len) h.fast[fill] = (uint16_t)((s << 4) | len);
+        }
+        return true;
+    }
+
+    int decode(const Huffman& h) {
+        if (bitCount < 15) refill();
+        uint16_t entry = h.fast[bitBuf & ((1 << FAST_BITS) - 1)];
+        if (entry) {
+            bits(entry & 15);
+            return entry >> 4;
+        }
+        int code = 0, first = 0, index = 0;
+        for (int len = 1; len < 16; ++len) {
+            code |= bits(1);
+            int count = h.count[len];
+            if (code - count < first) return h.symbol[index + (code - first)];
+            index += count;
+            first = (first + count) << 1;
+            code <<= 1;
+        }
+        return -1;
+    }
+
+    bool codes(const Huffman& lencode, const Huffman& distcode) {
+        static const short len_base[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+            35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+        static const short len_extra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+            3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+        static const short dist_base[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+            257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+        static const short dist_extra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+            7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+        for (;;) {
+            int sym = decode(lencode);
+            if (sym < 0 || exhausted()) return false;
+            if (sym < 256) out.push_back((char)sym);
+            else if (sym == 256) return true;
+            else {
+                sym -= 257;
+                if (sym >= 29) return false;
+                int len = len_base[sym] + bits(len_extra[sym]);
+                int dsym = decode(distcode);
+                if (dsym < 0 || dsym >= 30) return false;
+                size_t dist = dist_base[dsym] + bits(dist_extra[dsym]);
+                if (dist > out.size()) return false;
+                size_t from = out.size() - dist;
+                for (int k = 0; k < len; ++k) out.push_back(out[from + k]);
+            }
+        }
+    }
+
+    bool stored() {
+        bitBuf >>= bitCount & 7;  // to a byte boundary
+        bitCount -= bitCount & 7;
+        int len = bits(16);
+        int nlen = bits(16);
+        if (len != (~nlen & 0xffff)) return false;
+        for (; len > 0 && bitCount > 0; --len) out.push_back((char)bits(8));
+        if (exhausted() || pos + len > inLen) return false;
+        out.append(reinterpret_cast<const char*>(in + pos), len);
+        pos += len;
+        return true;
+    }
+
+    bool fixed() {
+        static Huffman lencode, distcode;
+        static bool built = [] {
+            short lengths[288];
+            for (int s = 0; s < 288; ++s) lengths[s] = s < 144 ? 8 : s < 256 ? 9 : s < 280 ? 7 : 8;
+            build(lencode, lengths, 288);
+            for (int s = 0; s < 30; ++s) lengths[s] = 5;
+            build(distcode, lengths, 30);
+            return true;
+        }();
+        (void)built;
+        return codes(lencode, distcode);
+    }
+
+    bool dynamic() {
+        static const short order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+        int nlen = bits(5) + 257;
+        int ndist = bits(5) + 1;
+        int ncode = bits(4) + 4;
+        if (nlen > 286 || ndist > 30) return false;
+        short lengths[320] = {};
+        for (int i = 0; i < ncode; ++i) lengths[order[i]] = bits(3);
+        Huffman lencode, distcode;
+        if (!build(lencode, lengths, 19)) return false;
+        for (int i = 0; i < nlen + ndist;) {
+            int sym = decode(lencode);
+            if (sym < 0 || exhausted()) return false;
+            if (sym < 16) {
+                lengths[i++] = sym;
+                continue;
+            }
+            int value = 0, repeat;
+            if (sym == 16) {
+                if (i == 0) return false;
+                value = lengths[i - 1];
+                repeat = 3 + bits(2);
+            }
+            else if (sym == 17) repeat = 3 + bits(3);
+            else repeat = 11 + bits(7);
+            if (i + repeat > nlen + ndist) return false;
+            while (repeat--) lengths[i++] = value;
+        }
+        if (lengths[256] == 0) return false;
+        if (!build(lencode, lengths, nlen) || !build(distcode, lengths + nlen, ndist)) return false;
+        return codes(lencode, distcode);
+    }
+
+    bool run() {
+        int last;
+        do {
+            last = bits(1);
+            int type = bits(2);
+            bool ok = type == 0 ? stored() : type == 1 ? fixed() : type == 2 ? dynamic() : false;
+            if (!ok || exhausted()) return false;
+        } while (!last);
+        return true;
+    }
+};
+
+// Entries of a zip archive, located through the central directory.
+class ZipArchive {
+public:
+    bool open(const std::string& path) {
+        entries.clear();
+        if (!file.open(path) || file.size() < 22) return false;
+        const unsigned char* data = bytes();
+        size_t size = file.size();
+        size_t eocd = size - 22;
+        size_t lowest = size > 22 + 65535 ? size - 22 - 65535 : 0;
+        while (read32(data + eocd) != 0x06054b50) {
+            if (eocd == lowest) return false;
+            --eocd;
+        }
+        size_t count = read16(data + eocd + 10);
+        size_t p = read32(data + eocd + 16);
+        for (size_t k = 0; k < count; ++k) {
+            if (p + 46 > size || read32(data + p) != 0x02014b50) return false;
+            Entry e;
+            e.method = read16(data + p + 10);
+            e.compressedSize = read32(data + p + 20);
+            e.size = read32(data + p + 24);
+            size_t name_len = read16(data + p + 28);
+            size_t extra_len = read16(data + p + 30);
+            size_t comment_len = read16(data + p + 32);
+            e.localOffset = read32(data + p + 42);
+            if (p + 46 + name_len > size) return false;
+            entries.emplace(std::string(reinterpret_cast<const char*>(data + p + 46), name_len), e);
+            p += 46 + name_len + extra_len + comment_len;
+        }
+        return true;
+    }
+
+    // Uncompressed contents of name; false if it is missing or corrupt.
+    bool read(const std::string& name, std::string& out) const {
+        out.clear();
+        auto it = entries.find(name);
+        if (it == entries.end()) return false;
+        const Entry& e = it->second;
+        const unsigned char* data = bytes();
+        if (e.localOffset + 30 > file.size() || read32(data + e.localOffset) != 0x04034b50) return false;
+        size_t start = e.localOffset + 30 + read16(data + e.localOffset + 26) + read16(data + e.localOffset + 28);
+        if (start + e.compressedSize > file.size()) return false;
+        out.reserve(e.size);
+        if (e.method == 0) out.assign(reinterpret_cast<const char*>(data + start), e.compressedSize);
+        else if (e.method != 8 || !Inflater::inflate(data + start, e.compressedSize, out)) return false;
+        return out.size() == e.size;
+    }
+
+private:
+    struct Entry {
+        int method;
+        size_t compressedSize, size, localOffset;
+    };
+    MappedFile file;
+    std::unordered_map<std::string, Entry> entries;
+
+    const unsigned char* bytes() const { return reinterpret_cast<const unsigned char*>(file.data()); }
+    static uint32_t read16(const unsigned char* p) { return p[0] | (p[1] << 8); }
+    static uint32_t read32(const unsigned char* p) { return read16(p) | (read16(p + 2) << 16); }
+};
+
+class XlsxFile : public CsvTable {
+public:
+    // Loads the first worksheet of path; false if it is not a readable workbook.
+    bool open(const std::string& path) {
+        cells.clear();
+        rowStart.assign(1, 0);
+        text.clear();
+        ZipArchive zip;
+        std::string xml;
+        if (!zip.open(path)) return false;
+        if (zip.read("xl/sharedStrings.xml", xml)) read_shared_strings(xml);
+        if (zip.read("xl/styles.xml", xml)) read_styles(xml);
+        if (!zip.read(first_sheet(zip), xml)) return false;
+        read_sheet(xml);
+        return true;
+    }
+
+private:
+    using Span = std::pair<size_t, size_t>;  // offset and length in text
+    enum TimeFormat : uint8_t { NOT_TIME, TIME_24H, TIME_12H };
+
+    std::string text;             // every cell value, back to back
+    std::vector<Span> shared;     // shared string -> its span in text
+    std::vector<TimeFormat> styleTime;  // cell style -> how its numbers print
+
+    // Part name of the first sheet in workbook order, or sheet1.xml when the
+    // workbook or its relationships do not name one.
+    static std::string first_sheet(const ZipArchive& zip) {
+        std::string workbook, rels;
+        if (!zip.read("xl/workbook.xml", workbook) || !zip.read("xl/_rels/workbook.xml.rels", rels)) return "xl/worksheets/sheet1.xml";
+        std::string_view id;
+        for (size_t p = workbook.find("<sheet"); p != std::string::npos && id.empty(); p = workbook.find("<sheet", p + 1)) {
+            if (is_tag(workbook, p, "sheet")) id = attribute(std::string_view(workbook).substr(p, workbook.find('>', p) - p), "r:id");
+        }
+        for (size_t p = rels.find("<Relationship"); p != std::string::npos && !id.empty(); p = rels.find("<Relationship", p + 1)) {
+            std::string_view tag = std::string_view(rels).substr(p, rels.find('>', p) - p);
+            if (!is_tag(rels, p, "Relationship") || attribute(tag, "Id") != id) continue;
+            std::string_view target = attribute(tag, "Target");
+            // relative to xl/, or absolute within the package
+            if (!target.empty() && target[0] == '/') return std::string(target.substr(1));
+            return "xl/" + std::string(target);
+        }
+        return "xl/worksheets/sheet1.xml";
+    }
+
+    // Value of attribute name inside a start tag, or empty.
+    static std::string_view attribute(std::string_view tag, std::string_view name) {
+        for (size_t p = tag.find(name); p != std::string_view::npos; p = tag.find(name, p + 1)) {
+            size_t eq = p + name.size();
+            if (p > 0 && tag[p - 1] == ' ' && eq + 1 < tag.size() && tag[eq] == '=' && tag[eq + 1] == '"') {
+                size_t end = tag.find('"', eq + 2);
+                return tag.substr(eq + 2, end == std::string_view::npos ? std::string_view::npos : end - eq - 2);
+            }
+        }
+        return {};
+    }
+
+    // True if a tag starts at p with exactly this name.
+    static bool is_tag(std::string_view xml, size_t p, std::string_view name) {
+        size_t after = p + 1 + name.size();
+        if (xml.compare(p + 1, name.size(), name) != 0 || after >= xml.size()) return false;
+        char c = xml[after];
+        return c == '>' || c == ' ' || c == '/';
+    }
+
+    static void append_utf8(std::string& out, uint32_t cp) {
+        if (cp < 0x80) out.push_back((char)cp);
+        else if (cp < 0x800) {
+            out.push_back((char)(0xC0 | (cp >> 6)));
+            out.push_back((char)(0x80 | (cp & 0x3F)));
+        }
+        else if (cp < 0x10000) {
+            out.push_back((char)(0xE0 | (cp >> 12)));
+            out.push_back((char)(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back((char)(0x80 | (cp & 0x3F)));
+        }
+        else {
+            out.push_back((char)(0xF0 | (cp >> 18)));
+            out.push_back((char)(0x80 | ((cp >> 12) & 0x3F)));
+            out.push_back((char)(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back((char)(0x80 | (cp & 0x3F)));
+        }
+    }
+
+    // Appends s with XML entities decoded.
+    static void append_decoded(std::string& out, std::string_view s) {
+        for (size_t i = 0; i < s.size(); ++i) {
+            size_t semi;
+            if (s[i] != '&' || (semi = s.find(';', i)) == std::string_view::npos) {
+                out.push_back(s[i]);
+                continue;
+            }
+            std::string_view name = s.substr(i + 1, semi - i - 1);
+            if (name == "amp") out.push_back('&');
+            else if (name == "lt") out.push_back('<');
+            else if (name == "gt") out.push_back('>');
+            else if (name == "quot") out.push_back('"');
+            else if (name == "apos") out.push_back('\'');
+            else if (name.size() > 1 && name[0] == '#') {
+                bool hex = name[1] == 'x' || name[1] == 'X';
+                uint32_t cp = 0;
+                std::from_chars(name.data() + (hex ? 2 : 1), name.data() + name.size(), cp, hex ? 16 : 10);
+                append_utf8(out, cp);
+            }
+            else out.append(s.substr(i, semi - i + 1));
+            i = semi;
+        }
+    }
+
+    // Appends the text of every <t> in body, skipping phonetic runs (<rPh>).
+    void append_runs(std::string_view body) {
+        for (size_t p = body.find('<'); p != std::string_view::npos; p = body.find('<', p + 1)) {
+            if (is_tag(body, p, "rPh")) {
+                size_t end = body.find("</rPh>", p);
+                if (end == std::string_view::npos) return;
+                p = end;
+            }
+            else if (is_tag(body, p, "t")) {
+                size_t open_end = body.find('>', p);
+                if (open_end == std::string_view::npos || body[open_end - 1] == '/') continue;
+                size_t close = body.find("</t>", open_end);
+                if (close == std::string_view::npos) return;
+                append_decoded(text, body.substr(open_end + 1, close - open_end - 1));
+                p = close;
+            }
+        }
+    }
+
+    void read_shared_strings(std::string_view xml) {
+        for (size_t p = xml.find("<si"); p != std::string_view::npos; p = xml.find("<si", p + 1)) {
+            if (!is_tag(xml, p, "si")) continue;
+            size_t start = text.size();
+            size_t open_end = xml.find('>', p);
+            if (open_end == std::string_view::npos) break;
+            if (xml[open_end - 1] != '/') {
+                size_t end = xml.find("</si>", open_end);
+                if (end == std::string_view::npos) end = xml.size();
+                append_runs(xml.substr(open_end + 1, end - open_end - 1));
+                p = end;
+            }
+            shared.push_back({ start, text.size() - start });
+        }
+    }
+
+    static TimeFormat builtin_time_format(int id) {
+        if (id == 18 || id == 19) return TIME_12H;
+        if ((id >= 20 && id <= 21) || (id >= 45 && id <= 47)) return TIME_24H;
+        return NOT_TIME;
+    }
+
+    static TimeFormat custom_time_format(std::string_view code) {
+        std::string lower;
+        append_decoded(lower, code);
+        for (auto& c : lower) c = (char)tolower((unsigned char)c);
+        if (lower.find_first_of("yd") != std::string::npos) return NOT_TIME;
+        if (lower.find('h') == std::string::npos && lower.find('s') == std::string::npos) return NOT_TIME;
+        return lower.find("am/pm") != std::string::npos ? TIME_12H : TIME_24H;
+    }
+
+    void read_styles(std::string_view xml) {
+        std::unordered_map<int, TimeFormat> custom;
+        for (size_t p = xml.find("<numFmt "); p != std::string_view::npos; p = xml.find("<numFmt ", p + 1)) {
+            std::string_view tag = xml.substr(p, xml.find('>', p) - p);
+            int id = 0;
+            std::string_view id_text = attribute(tag, "numFmtId");
+            std::from_chars(id_text.data(), id_text.data() + id_text.size(), id);
+            custom[id] = custom_time_format(attribute(tag, "formatCode"));
+        }
+        size_t begin = xml.find("<cellXfs");
+        size_t end = xml.find("</cellXfs>");
+        if (begin == std::string_view::npos || end == std::string_view::npos) return;
+        for (size_t p = xml.find("<xf", begin); p != std::string_view::npos && p < end; p = xml.find("<xf", p + 1)) {
+            if (!is_tag(xml, p, "xf")) continue;
+            std::string_view tag = xml.substr(p, xml.find('>', p) - p);
+            int id = 0;
+            std::string_view id_text = attribute(tag, "numFmtId");
+            std::from_chars(id_text.data(), id_text.data() + id_text.size(), id);
+            auto it = custom.find(id);
+            styleTime.push_back(it != custom.end() ? it->second : builtin_time_format(id));
+        }
+    }
+
+    // Appends a serial time of day the way a CSV export prints it.
+    void append_time(std::string_view number, TimeFormat format) {
+        double value = 0;
+        std::string digits(number);
+        char* end = nullptr;
+        value = strtod(digits.c_str(), &end);
+        if (end == digits.c_str()) {
+            text.append(number);
+            return;
+        }
+        long long seconds = llround((value - floor(value)) * 86400.0) % 86400;
+        int h = (int)(seconds / 3600), m = (int)(seconds / 60 % 60), s = (int)(seconds % 60);
+        char buf[16];
+        if (format == TIME_12H) snprintf(buf, sizeof buf, "%02d:%02d:%02d %s", h % 12 == 0 ? 12 : h % 12, m, s, h < 12 ? "AM" : "PM");
+        else snprintf(buf, sizeof buf, "%02d:%02d:%02d", h, m, s);
+        text.append(buf);
+    }
+
+    // Cell text without surrounding spaces or tabs, as the CSV reader returns it.
+    std::string_view trimmed(Span span) const {
+        std::string_view cell(text.data() + span.first, span.second);
+        size_t first = cell.find_first_not_of(" \t");
+        if (first == std::string_view::npos) return {};
+        return cell.substr(first, cell.find_last_not_of(" \t") - first + 1);
+    }
+
+    // Zero-based column of a reference like "AB12".
+    static int column_of(std::string_view ref) {
+        int col = 0;
+        size_t i = 0;
+        for (; i < ref.size() && isalpha((unsigned char)ref[i]); ++i) col = col * 26 + (toupper((unsigned char)ref[i]) - 'A' + 1);
+        return i == 0 ? -1 : col - 1;
+    }
+
+    // Value of one <c> element: tag is the start tag, body what lies inside.
+    Span cell_value(std::string_view tag, std::string_view body) {
+        std::string_view type = attribute(tag, "t");
+        size_t start = text.size();
+        if (type == "inlineStr") {
+            append_runs(body);
+            return { start, text.size() - start };
+        }
+        size_t v = body.find("<v");
+        if (v == std::string_view::npos || !is_tag(body, v, "v")) return { 0, 0 };
+        size_t open_end = body.find('>', v);
+        size_t close = body.find("</v>", open_end);
+        if (open_end == std::string_view::npos || close == std::string_view::npos) return { 0, 0 };
+        std::string_view raw = body.substr(open_end + 1, close - open_end - 1);
+        if (type == "s") {
+            size_t index = 0;
+            std::from_chars(raw.data(), raw.data() + raw.size(), index);
+            return index < shared.size() ? shared[index] : Span{ 0, 0 };
+        }
+        if (type == "b") text.append(raw == "1" ? "TRUE" : "FALSE");
+        else if (type.empty() || type == "n") {
+            size_t style = 0;
+            std::string_view s = attribute(tag, "s");
+            std::from_chars(s.data(), s.data() + s.size(), style);
+            TimeFormat format = style < styleTime.size() ? styleTime[style] : NOT_TIME;
+            if (format != NOT_TIME) append_time(raw, format);
+            else text.append(raw);
+        }
+        else append_decoded(text, raw);
+        return { start, text.size() - start };
+    }
+
+    void read_sheet(std::string_view xml) {
+        std::vector<Span> spans;          // every cell of every row
+        std::vector<size_t> row_begin;    // row -> its first span
+        size_t width = 0;
+        size_t p = xml.find("<sheetData");
+        bool in_row = false;
+        long long next_row = 1;
+        while (p != std::string_view::npos && (p = xml.find('<', p + 1)) != std::string_view::npos) {
+            size_t tag_end = xml.find('>', p);
+            if (tag_end == std::string_view::npos) break;
+            std::string_view tag = xml.substr(p, tag_end - p);
+            bool self_closing = tag.back() == '/';
+            if (is_tag(xml, p, "row")) {
+                long long r = next_row;
+                std::string_view ref = attribute(tag, "r");
+                std::from_chars(ref.data(), ref.data() + ref.size(), r);
+                for (; next_row < r; ++next_row) row_begin.push_back(spans.size());  // rows with no element
+                row_begin.push_back(spans.size());
+                ++next_row;
+                in_row = !self_closing;
+            }
+            else if (in_row && is_tag(xml, p, "c")) {
+                int col = column_of(attribute(tag, "r"));
+                size_t row_cells = spans.size() - row_begin.back();
+                if (col < 0) col = (int)row_cells;
+                while (row_cells < (size_t)col) {
+                    spans.push_back({ 0, 0 });
+                    ++row_cells;
+                }
+                if (self_closing) spans.push_back({ 0, 0 });
+                else {
+                    size_t close = xml.find("</c>", tag_end);
+                    if (close == std::string_view::npos) break;
+                    spans.push_back(cell_value(tag, xml.substr(tag_end + 1, close - tag_end - 1)));
+                    tag_end = close + 3;
+                }
+            }
+            else if (xml.compare(p, 6, "</row>") == 0) in_row = false;
+            else if (xml.compare(p, 12, "</sheetData>") == 0) break;
+            p = tag_end;
+        }
+        for (size_t r = 0; r < row_begin.size(); ++r) {
+            size_t end = r + 1 < row_begin.size() ? row_begin[r + 1] : spans.size();
+            width = std::max(width, end - row_begin[r]);
+        }
+        // trailing empty rows are dropped, as a CSV export would
+        while (!row_begin.empty()) {
+            size_t begin = row_begin.back();
+            bool blank = true;
+            for (size_t k = begin; k < spans.size() && blank; ++k) blank = spans[k].second == 0;
+            if (!blank) break;
+            spans.resize(begin);
+            row_begin.pop_back();
+        }
+        cells.reserve(row_begin.size() * width);
+        for (size_t r = 0; r < row_begin.size(); ++r) {
+            size_t end = r + 1 < row_begin.size() ? row_begin[r + 1] : spans.size();
+            for (size_t k = row_begin[r]; k < end; ++k) cells.push_back(trimmed(spans[k]));
+            for (size_t k = end - row_begin[r]; k < width; ++k) cells.push_back(std::string_view());
+            end_row();
+        }
+    }
+};